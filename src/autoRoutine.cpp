@@ -1,13 +1,34 @@
 // Auton routine, moved out of main to reduce clutter
 
 #include "autoRoutine.hpp"
+#include <optional>
 #include "util/util.hpp"
 #include "systemmanager.hpp"
 
-// Hack to run driveToPointAsync as blocking
-#define DRIVE_TO_POINT(x, y) util::runAsBlocking([&] { auton.driveToPointAsync({x, y}); }, [&] { return auton.isSettled(); });
-// Hack to run turnToAngleAsync as blocking
-#define TURN_TO_ANGLE_DEG(a) util::runAsBlocking([&] { auton.turnToAngleAsync(d2r(a)); }, [&] { return auton.isSettled(); });
+// Runs driveToPointAsync as blocking
+#define DRIVE_TO_POINT(x, y) auton.driveToPointAsync({x, y}); auton.waitUntilSettled();
+// Runs followPathAsync as blocking. Takes the waypoints, e.g. FOLLOW_PATH({0, 0}, {0, 24})
+#define FOLLOW_PATH(...) auton.followPathAsync(util::Path({__VA_ARGS__})); auton.waitUntilSettled();
+// Runs driveToPoseAsync as blocking. Drives to x, y while turning to a heading in degrees
+#define DRIVE_TO_POSE(x, y, a) auton.driveToPoseAsync({x, y, d2r(a)}); auton.waitUntilSettled();
+// Runs turnToAngleAsync as blocking
+#define TURN_TO_ANGLE_DEG(a) auton.turnToAngleAsync(d2r(a)); auton.waitUntilSettled();
+
+namespace {
+    /**
+     * Moves the intake from the routine. Takes it over from any indexer job, whose intake commands are ignored
+     * until the lease is reset. The lease is released when the routine returns, whichever way it does.
+     *
+     * \param lease The routine's intake lease, acquired on the first call.
+     *
+     * \param velocity The intake velocity in rpm.
+     */
+    void intakeVelocity(std::optional<ActuatorLease> &lease, int velocity) {
+        if(!lease)
+            lease.emplace(ACTUATOR_INTAKE, ARBITER_PRIORITY_ROUTINE, "skills routine");
+        intake.moveVelocity(velocity);
+    }
+}
 
 void autoRoutine::skillsAuton()
 {
@@ -15,28 +36,27 @@ void autoRoutine::skillsAuton()
     Starting on the red side, on the right of the middle goal
     "Up" = forward
     */
+    std::optional<ActuatorLease> intakeLease;
 
     //Moves the preload ball to the "upper" location, Also moves the upper roller to extend the hood
-    util::runAsync([&] { indexer.getUpperBall(); });
+    indexer.getUpperBallAsync();
 
     /* Getting the first red */
     DRIVE_TO_POINT(-72 + GOAL_RADIUS_IN / 2 + CHASSIS_WIDTH / 2, 24)
-    intake.moveVelocity(-200); //Expand intake
+    intakeVelocity(intakeLease, -200); //Expand intake
     TURN_TO_ANGLE_DEG(90)
-    intake.moveVelocity(0); //Stops the manual intake movement from expansion
-    util::runAsync([&] { indexer.getLowerBall(); });
+    intakeVelocity(intakeLease, 0); //Stops the manual intake movement from expansion
+    intakeLease.reset(); // Hands the intake back to the indexer jobs
+    indexer.getLowerBallAsync();
     DRIVE_TO_POINT(-36, 24)
 
-    //Moves futher from the goal to prepare entering it at 45 degrees
-    DRIVE_TO_POINT(-30, 30)
-    TURN_TO_ANGLE_DEG(135)
-
     /* Scoring Right Bottom Goal*/
 
-    //The middle goal has a very small tolerance, so we need as much accuracy as possible
+    //Swings further from the goal and enters it at 45 degrees in one motion
+    //The goal has a very small tolerance, so we need as much accuracy as possible
     //Enters the goal slowly to minimize vibration from hitting the goal
     auton.withSpeed(0.75);
-    DRIVE_TO_POINT(-17, 17)
+    FOLLOW_PATH({-36, 24}, {-30, 30}, {-17, 17})
     auton.resetSettings(); //Resets the settings to default.
     //The robot has 2 red balls
     indexer.score();        //Score the upper one
@@ -45,14 +65,15 @@ void autoRoutine::skillsAuton()
     indexer.getLowerBall(); //Gets a blue ball to the lower position to descore it
     pros::delay(250);       //Waits a bit for stability
 
-    intake.moveVelocity(-10); //Moves intake slowly backward to make sure we get the second blue ball
+    intakeVelocity(intakeLease, -10); //Moves intake slowly backward to make sure we get the second blue ball
     DRIVE_TO_POINT(-36, 46)
     TURN_TO_ANGLE_DEG(170)
+    intakeLease.reset(); // discardLowerBall takes the intake from here
     indexer.discardLowerBall();
     TURN_TO_ANGLE_DEG(-90)
 
     /* Getting the red ball in the middle */
-    util::runAsync([&] { indexer.getLowerBall(); });
+    indexer.getLowerBallAsync();
 
     DRIVE_TO_POINT(-73.8, 46.5)
 
@@ -65,11 +86,7 @@ void autoRoutine::skillsAuton()
     //Resettings the position of the robot based on the heading.
     //The robot might approach the goal from different angles, so we can't just reset to a single position+heading
     //We calculate the robot's position using the heading and the distance between the robot's tracking center to the center of the goal
-    odometry.reset(
-        {-72 + (GOAL_RADIUS_IN / 2 + 9.25) * -sin(odometry.getPos().angle),
-         5.8 + (GOAL_RADIUS_IN / 2 + 9.25) * -cos(odometry.getPos().angle),
-         r2d(odometry.getPos().angle)},
-        false);
+    odometry.relocalizeAgainst(field::bottomMiddleGoal);
     pros::delay(250);
     indexer.score();
     pros::delay(500);
@@ -78,9 +95,10 @@ void autoRoutine::skillsAuton()
     indexer.getLowerBall();
 
     //Moves the intake forward when backing out so we don't take the red ball out
-    intake.moveVelocity(200);
+    intakeVelocity(intakeLease, 200);
     DRIVE_TO_POINT(-84, 48)
-    intake.moveVelocity(0);
+    intakeVelocity(intakeLease, 0);
+    intakeLease.reset(); // Hands the intake back to the indexer jobs
 
     //Discard the blue ball in the corner we started
     TURN_TO_ANGLE_DEG(130)
@@ -88,34 +106,37 @@ void autoRoutine::skillsAuton()
 
     /* Getting the lower left red ball */
     TURN_TO_ANGLE_DEG(-132)
-    util::runAsync([&] { indexer.getUpperBall(); });
+    indexer.getUpperBallAsync();
     DRIVE_TO_POINT(-108, 24 - 2)
 
     //Moves further from the goal to prepare entering it at 45 degrees
-    DRIVE_TO_POINT(-142 + 34, 34)
-    TURN_TO_ANGLE_DEG(-135)
+    DRIVE_TO_POSE(-142 + 34, 34, -135)
 
     //Enters the goal fullspeed as we dont need as much accuracy as before
+    //Finishes as soon as the wheels start slipping against the goal instead of pushing until it stalls
+    auton.withContactAction(AutoSettings::CONTACT_END);
     DRIVE_TO_POINT(-142 + 17 - 3, 16 - 4)
+    auton.resetSettings();
     indexer.score();        //Scores the red ball
     indexer.getLowerBall(); //Gets the blue ball to descore it
     pros::delay(250);
 
     //Heading based reset
-    odometry.reset({-144 + 5.8 + (GOAL_RADIUS_IN / 2 + 9.25) * -sin(odometry.getPos().angle), 5.8 + (GOAL_RADIUS_IN / 2 + 9.25) * -cos(odometry.getPos().angle), r2d(odometry.getPos().angle)}, false);
+    odometry.relocalizeAgainst(field::bottomLeftGoal);
     //Will be {-138, 16.34, -135} ideally
     pros::delay(250);
 
-    intake.moveVelocity(-10);              //Moves the intake slowly backward to grab onto the second blue ball
+    intakeVelocity(intakeLease, -10); //Moves the intake slowly backward to grab onto the second blue ball
     DRIVE_TO_POINT(-144 + 48 - 3, 72 - 24) //Backing out of the goal
+    intakeLease.reset(); // discardLowerBall takes the intake from here
     indexer.discardLowerBall();
 
     /* Getting the two balls on the left-middle of the field */
     TURN_TO_ANGLE_DEG(0)
-    util::runAsync([&] { indexer.getUpperBall(); });
+    indexer.getUpperBallAsync();
     DRIVE_TO_POINT(-144 + 48 - 3, 72 - 2) //Driving to the first ball
     TURN_TO_ANGLE_DEG(-90)
-    util::runAsync([&] { indexer.getLowerBall(); });
+    indexer.getLowerBallAsync();
 
     //The second ball, the goal and the robot are all on the same line.
     //We split the movement to 2 parts to give the second ball time to go in
@@ -128,42 +149,44 @@ void autoRoutine::skillsAuton()
     // Heading based reset
     // We find that our haeding is off by 3 degrees here consistently, so we just added 3 degrees to it.
     // The skills run is coming to an end and we don't need the highest amount of accuracy
-    odometry.reset({-144 + 5.8 + (GOAL_RADIUS_IN / 2 + 9.25) * -sin(odometry.getPos().angle), 72 + (GOAL_RADIUS_IN / 2 + 9.25) * -cos(odometry.getPos().angle), r2d(odometry.getPos().angle) + 3}, false);
+    odometry.relocalizeAgainst(field::middleLeftGoal, 3);
     pros::delay(250);
 
     //Backing out of the goal and moving the remaining red ball to the upper position
-    intake.moveVelocity(200);
+    intakeVelocity(intakeLease, 200);
     DRIVE_TO_POINT(-144 + 36, 73)
-    intake.moveVelocity(0);
-    util::runAsync([&] { indexer.getUpperBall(); });
+    intakeVelocity(intakeLease, 0);
+    intakeLease.reset(); // Hands the intake back to the indexer jobs
+    indexer.getUpperBallAsync();
 
     /* Left Top Goal */
     //Moves the intake outward incase we accidentally come into contact with the left top ball
     //This helps us in pushing the ball out of the way 
-    intake.moveVelocity(50);
+    intakeVelocity(intakeLease, 50);
     TURN_TO_ANGLE_DEG(-16)
-    DRIVE_TO_POINT(-144 + 24, 144 - 24)
-    TURN_TO_ANGLE_DEG(-45)
-    intake.moveVelocity(0);
+    DRIVE_TO_POSE(-144 + 24, 144 - 24, -45)
+    intakeVelocity(intakeLease, 0);
+    intakeLease.reset(); // Hands the intake back to the indexer jobs
+    auton.withContactAction(AutoSettings::CONTACT_END);
     DRIVE_TO_POINT(-144 + 16 - 0.5, 144 - 16 - 2)//Last goal of the skills run, driving into it full speed
+    auton.resetSettings();
 
     indexer.score();
     pros::delay(250);
     //Heading based reset incase we add more things after this point
-    odometry.reset({-142 + 5.8 + (GOAL_RADIUS_IN / 2 + 9.25) * -sin(odometry.getPos().angle), 142 - 5.8 + (GOAL_RADIUS_IN / 2 + 9.25) * -cos(odometry.getPos().angle), r2d(odometry.getPos().angle)}, false);
+    odometry.relocalizeAgainst(field::topLeftGoal);
     pros::delay(250);
 
     //Spins intake backward to not pick up the blue ball, incase we want to rush the last few seconds to get another goal
-    intake.moveVelocity(150);
-    DRIVE_TO_POINT(-144+36, 144-46)
-    intake.moveVelocity(0);
-    TURN_TO_ANGLE_DEG(90)
+    intakeVelocity(intakeLease, 150);
+    DRIVE_TO_POSE(-144+36, 144-46, 90)
+    intakeVelocity(intakeLease, 0);
+    intakeLease.reset(); // Hands the intake back to the indexer jobs
 
     /* Getting the red ball in the middle */
-    util::runAsync([&] { indexer.getUpperBall(); });
+    indexer.getUpperBallAsync();
 
-    DRIVE_TO_POINT(-73.8, 144-46);
-    
+    DRIVE_TO_POINT(-73.8, 144-46)
     TURN_TO_ANGLE_DEG(0)
     DRIVE_TO_POINT(-72, 144-18)
 
@@ -172,20 +195,17 @@ void autoRoutine::skillsAuton()
     //Resettings the position of the robot based on the heading.
     //The robot might approach the goal from different angles, so we can't just reset to a single position+heading
     //We calculate the robot's position using the heading and the distance between the robot's tracking center to the center of the goal
-    odometry.reset(
-        {-72 + (GOAL_RADIUS_IN / 2 + 9.25) * -sin(odometry.getPos().angle),
-         144-5.8 + (GOAL_RADIUS_IN / 2 + 9.25) * -cos(odometry.getPos().angle),
-         r2d(odometry.getPos().angle)},
-        false);
+    odometry.relocalizeAgainst(field::topMiddleGoal);
     pros::delay(250);
 
     //Gets the lower blue ball to descore it.
     indexer.getLowerBall();
 
     //Moves the intake forward when backing out so we don't take the red ball out
-    intake.moveVelocity(200);
+    intakeVelocity(intakeLease, 200);
     DRIVE_TO_POINT(-60, 144-48)
-    intake.moveVelocity(0);
+    intakeVelocity(intakeLease, 0);
+    intakeLease.reset(); // Hands the intake back to the indexer jobs
 
     //Discard the blue ball in the corner we started
     TURN_TO_ANGLE_DEG(-40)
@@ -193,25 +213,25 @@ void autoRoutine::skillsAuton()
 
     /* Getting the lower left red ball */
     TURN_TO_ANGLE_DEG(42)
-    util::runAsync([&] { indexer.getUpperBall(); });
+    indexer.getUpperBallAsync();
     DRIVE_TO_POINT(-36, 144-22)
 
     //Moves further from the goal to prepare entering it at 45 degrees
-    DRIVE_TO_POINT(-34, 144-34)
-    TURN_TO_ANGLE_DEG(45)
+    DRIVE_TO_POSE(-34, 144-34, 45)
 
     //Enters the goal fullspeed as we dont need as much accuracy as before
+    auton.withContactAction(AutoSettings::CONTACT_END);
     DRIVE_TO_POINT(-17 + 3, 144 - (16 - 3))
+    auton.resetSettings();
     indexer.score();        //Scores the red ball
     pros::delay(250);
 
     //Heading based reset
-    odometry.reset({5.8 + (GOAL_RADIUS_IN / 2 + 9.25) * -sin(odometry.getPos().angle), 144 - 5.8 + (GOAL_RADIUS_IN / 2 + 9.25) * -cos(odometry.getPos().angle), r2d(odometry.getPos().angle)}, false);
+    odometry.relocalizeAgainst(field::topRightGoal);
     pros::delay(250);
 
-    intake.moveVelocity(150);
-    DRIVE_TO_POINT(-48+3, 72 + 24) //Backing out of the goal
-    TURN_TO_ANGLE_DEG(180)
+    intakeVelocity(intakeLease, 150);
+    DRIVE_TO_POSE(-48+3, 72 + 24, 180) //Backing out of the goal
 
-    //End of our current skills autonomous routine
+    //End of our current skills autonomous routine. The intake lease is released on the way out
 }
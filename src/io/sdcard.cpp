@@ -53,13 +53,25 @@ void LocalStorage::writeConfigs() {
             "Auton side (top/bottom): %u\n"
             "Driver skills mode: %u\n"
             "Debugging: %u\n"
-            "Logging enable: %u",
+            "Logging enable: %u\n"
+            "Tracking width: %f\n"
+            "Back wheel offset: %f\n"
+            "Right wheel scale: %f\n"
+            "Drive kS: %f %f %f %f\n"
+            "Drive kV: %f %f %f %f\n"
+            "Drive kA: %f %f %f %f",
             robotConfigs.auton,
             robotConfigs.autonSide&AutonMode::RED?1:0,
             robotConfigs.autonSide&AutonMode::TOP?1:0,
             robotConfigs.driverSkills,
             robotConfigs.debugging,
-            robotConfigs.loggingEnable
+            robotConfigs.loggingEnable,
+            robotConfigs.trackingWidth,
+            robotConfigs.backToCenter,
+            robotConfigs.rightWheelScale,
+            robotConfigs.driveKS[0], robotConfigs.driveKS[1], robotConfigs.driveKS[2], robotConfigs.driveKS[3],
+            robotConfigs.driveKV[0], robotConfigs.driveKV[1], robotConfigs.driveKV[2], robotConfigs.driveKV[3],
+            robotConfigs.driveKA[0], robotConfigs.driveKA[1], robotConfigs.driveKA[2], robotConfigs.driveKA[3]
             );
     fclose(confFileHandle);
 }
@@ -113,6 +125,21 @@ void LocalStorage::readConfigs() {
                 robotConfigs.debugging = (bool)std::stoi(value);
             else if(input == "Logging enable")
                 robotConfigs.loggingEnable = (bool)std::stoi(value);
+            else if(input == "Tracking width")
+                robotConfigs.trackingWidth = std::stod(value);
+            else if(input == "Back wheel offset")
+                robotConfigs.backToCenter = std::stod(value);
+            else if(input == "Right wheel scale")
+                robotConfigs.rightWheelScale = std::stod(value);
+            else if(input == "Drive kS")
+                sscanf(value.c_str(), "%lf %lf %lf %lf", &robotConfigs.driveKS[0], &robotConfigs.driveKS[1],
+                       &robotConfigs.driveKS[2], &robotConfigs.driveKS[3]);
+            else if(input == "Drive kV")
+                sscanf(value.c_str(), "%lf %lf %lf %lf", &robotConfigs.driveKV[0], &robotConfigs.driveKV[1],
+                       &robotConfigs.driveKV[2], &robotConfigs.driveKV[3]);
+            else if(input == "Drive kA")
+                sscanf(value.c_str(), "%lf %lf %lf %lf", &robotConfigs.driveKA[0], &robotConfigs.driveKA[1],
+                       &robotConfigs.driveKA[2], &robotConfigs.driveKA[3]);
         }
         configFile.close(); // Close handle
     }
@@ -34,6 +34,14 @@ class LocalStorage {
         bool debugging; // Debug mode
         bool loggingEnable;
         double startingY; // Starting Y value in inches
+        // Odometry constants, measured by the calibration routine
+        double trackingWidth; // Distance between the left and right tracking wheels in inches
+        double backToCenter; // Distance between the back tracking wheel and the tracking center in inches
+        double rightWheelScale; // Effective diameter of the right tracking wheel relative to the left one
+        // Drive feedforward gains per wheel (lf, lr, rf, rr), measured by the sysid routine
+        double driveKS[4]; // Millivolts
+        double driveKV[4]; // Millivolts per inch per second
+        double driveKA[4]; // Millivolts per inch per second squared
     };
     LocalStorage();
 
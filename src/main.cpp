@@ -25,7 +25,13 @@ LocalStorage::RobotConfigs robotConfigs = {
 	LocalStorage::AutonMode::RED_BOTTOM, // Side
 	false,			// Debug mode
 	true,			// Logging enable
-	STARTING_Y_IN	// Starting Y value in inches
+	STARTING_Y_IN,	// Starting Y value in inches
+	ENC_BASE_WIDTH_IN,	// Tracking width
+	BACK_TO_CENTER_IN,	// Back wheel offset
+	1.0,			// Right wheel scale
+	{DRIVE_FF_KS, DRIVE_FF_KS, DRIVE_FF_KS, DRIVE_FF_KS},	// Drive kS
+	{DRIVE_FF_KV, DRIVE_FF_KV, DRIVE_FF_KV, DRIVE_FF_KV},	// Drive kV
+	{DRIVE_FF_KA, DRIVE_FF_KA, DRIVE_FF_KA, DRIVE_FF_KA}	// Drive kA
 };
 
 //Base drive
@@ -71,9 +77,12 @@ LocalStorage localStorage;
 Controller controllerMaster(pros::E_CONTROLLER_MASTER);
 
 //Subsystems
+ActuatorArbiter arbiter;
+MotorCommander motorCommander;
 DriveSubsystem drive;
 IntakeSubsystem intake;
 SelfCheck selfCheck(std::vector<int> (SELFCHECK_PORTS));
+MotorTelemetry telemetry(std::vector<int> (SELFCHECK_PORTS));
 
 pros::Imu inertialSensor(INERTIAL_SENSOR);
 HeadingSensor gyroSystem(&inertialSensor); // Also supports being passed a gyro instead of IMU
@@ -114,6 +123,7 @@ void initialize() {
 
     menu.controllerNavigation = true;
     menu.startTask();
+    telemetry.startTask();
     selfCheck.startTask();
 
     rollerMtrGrp.setBrakeMode(okapi::AbstractMotor::brakeMode::hold); // Consider brake so it heats up less?
@@ -131,6 +141,23 @@ void disabled() {
     intake.coast();
     rollerMtrGrp.setBrakeMode(okapi::AbstractMotor::brakeMode::coast);
 
+    // Finish writing the auton's odometry recording, if there is one
+    odometry.stopRecording();
+
+    // Logs what sampling the motors has cost so far
+    TelemetryStats stats = telemetry.getStats();
+    char logBuf[128];
+    sprintf(logBuf, "Telemetry: %lu cycles, %.0f us average, %lu us worst, %lu retried reads", (unsigned long)stats.cycles,
+            stats.averageMicros, (unsigned long)stats.worstMicros, (unsigned long)stats.retries);
+    localStorage.log(logBuf);
+    // And how many commands each motor got, for the load on the smart port bus
+    int length = sprintf(logBuf, "Motor writes:");
+    for (int port : selfCheck.ports)
+        if (length < (int)sizeof(logBuf))
+            length += snprintf(logBuf + length, sizeof(logBuf) - length, " %d:%lu", port,
+                               (unsigned long)motorCommander.getStats(port).totalWrites);
+    localStorage.log(logBuf);
+
     menu.startTask();
 }
 
@@ -158,6 +185,9 @@ void competition_initialize() {} // This is pretty useless because we mostly deb
  * from where it left off.
  */
 void autonomous() {
+    // Anything a stopped opcontrol or earlier run of the routine still holds would keep the routine from moving
+    arbiter.releaseAll(ARBITER_PRIORITY_DRIVER);
+
     util::runAsync([&]{
         localStorage.log("--- START OF AUTON ---");
         drive.brake();
@@ -169,6 +199,9 @@ void autonomous() {
     });
 
     odometry.resetForAuton();
+    // Record the raw odometry sensors in debug runs so they can be replayed off the robot
+    if(robotConfigs.debugging && !odometry.startRecording())
+        localStorage.log("Could not start odometry recording");
     odometry.startTask();
     localStorage.log("Resetted odometry");
     pros::delay(15);
@@ -191,6 +224,12 @@ void autonomous() {
  * task, not resume it from where it left off.
  */
 void opcontrol() {
+    // Takes the drive and intake back from autonomous. The routine's task may have been stopped while it held them,
+    // and AutoDrive may still have moves queued
+    auton.stop();
+    arbiter.releaseAll(ARBITER_PRIORITY_DRIVER);
+    ActuatorToken driverToken = arbiter.acquire(ACTUATOR_DRIVE | ACTUATOR_INTAKE, ARBITER_PRIORITY_DRIVER, "driver");
+
     drive.brake();
     intake.moveVoltage(0);
     drive.moveRPM(0);
@@ -201,6 +240,11 @@ void opcontrol() {
     if(robotConfigs.driverSkills) // disable controller menu navigation if in driver skills
         menu.controllerNavigation = false;
 
+    // Wheel slip from odometry, to log when the driver starts pushing into something
+    WheelSlip slip;
+    bool lastContact = false;
+    char slipBuf[80];
+
     // delay 50ms on starting opcontrol or odometry can sometimes have problems
     // opcontrol loop poll frequency is every 20ms, 50Hz
     for(pros::delay(50); true; pros::delay(20)) {
@@ -208,6 +252,14 @@ void opcontrol() {
         if(drive.getStalling() && robotConfigs.debugging)
             localStorage.log("Stalling!" "\a"); // Beep if stalling
 
+        // Slipping shows up before stalling does. Only logged when it starts, the odometry task only runs when debugging
+        slip = odometry.getSlip();
+        if(slip.contact && !lastContact && robotConfigs.debugging) {
+            sprintf(slipBuf, "Slipping! %.2f %.2f %.2f %.2f", slip.ratio.lf, slip.ratio.lr, slip.ratio.rf, slip.ratio.rr);
+            localStorage.log(slipBuf);
+        }
+        lastContact = slip.contact;
+
         // Disable opcontrol-related stuff in test builds
         #ifdef TEST_BUILD
         continue;
@@ -240,10 +292,16 @@ void opcontrol() {
                 case AutoDrive::AutoFlag::IDLE:
                     if(controllerMaster.getBtnNew((DEBUG_STRAIGHT))) {
                         drive.brake();
+                        // AutoDrive can't move the drive while the driver holds it
+                        arbiter.release(driverToken);
+                        driverToken = 0;
                         auton.driveToPointAsync({0,24});
                     }
-                    else
+                    else {
+                        if(driverToken == 0)
+                            driverToken = arbiter.acquire(ACTUATOR_DRIVE | ACTUATOR_INTAKE, ARBITER_PRIORITY_DRIVER, "driver");
                         drive.handleDriver();
+                    }
                     break;
                 default:
                     if (!controllerMaster.getBtnRaw(DEBUG_STRAIGHT))
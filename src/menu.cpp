@@ -3,6 +3,9 @@
 #include <experimental/random>
 #include "pros/apix.h"
 #include "systemmanager.hpp"
+#include "systemmanager/calibration.hpp"
+#include "systemmanager/sysid.hpp"
+#include "util/util.hpp"
 #include "profiles.hpp"
 
 #ifdef LOGO_NAME
@@ -97,6 +100,20 @@ void Menu::menuTaskFn(void *param) {
                 }
                 break;
             case 7:
+                pros::lcd::print(2, "\t> %u: Calibrate odometry", menu->getCurrentMenuId());
+                pros::lcd::print(3, "\t    W: %.2f, B: %.2f, R: %.3f", robotConfigs.trackingWidth,
+                                 robotConfigs.backToCenter, robotConfigs.rightWheelScale);
+                if (menu->getNewOkBtn())
+                    util::runAsync([&] { calibration::run(); }); // Robot spins and strafes in place for about 20 seconds
+                break;
+            case 8:
+                pros::lcd::print(2, "\t> %u: Measure drive feedforward", menu->getCurrentMenuId());
+                pros::lcd::print(3, "\t    kS: %.0f, kV: %.1f, kA: %.2f", robotConfigs.driveKS[0], robotConfigs.driveKV[0],
+                                 robotConfigs.driveKA[0]);
+                if (menu->getNewOkBtn())
+                    util::runAsync([&] { sysid::run(); }); // Robot drives forward and back about 4 feet for about 12 seconds
+                break;
+            case 9:
                 pros::lcd::print(2, "\t> %u: Enable graphics, disable menu", menu->getCurrentMenuId());
                 pros::lcd::clear_line(3);
                 if (menu->getNewOkBtn()) {
@@ -4,7 +4,7 @@
 #include "okapi/api.hpp"
 
 // The total number of menu items
-#define MENU_LIMIT 7
+#define MENU_LIMIT 9
 
 class Menu {
 private:
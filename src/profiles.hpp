@@ -5,10 +5,12 @@
 #define LOGO_NAME leroi
 #define CONFIGFILE "/usd/configs.txt"
 #define LOGFILE "/usd/log.txt"
+#define ODOM_RECORD_FILE "/usd/odom.bin"
 #define DEBUG_PORT "/dev/20" // putting down port 20 because its *generally* not used
 
 /* Other field measurements */
 #define GOAL_RADIUS_IN 11.29
+#define GOAL_INSET_IN 5.8 // Distance between a wall and the center of a goal against it
 
 /* Wheel related */
 #define WHEEL_DIAM_REAL_IN 4.02
@@ -30,6 +32,8 @@
 #define TICKS_PER_ROTATION 360
 #define SIDE_ENC_TO_IN SIDE_DIAM_IN * M_PI / 360
 #define BACK_ENC_TO_IN BACK_DIAM_IN * M_PI / 360
+// Drive motor encoders report degrees as if the wheels were WHEEL_DIAM_IN wide (see the 200rpm hack above)
+#define DRIVE_ENC_TO_IN (WHEEL_DIAM_IN * M_PI / 360)
 
 /* Chassis measurements */
 #define CHASSIS_WIDTH 13.5
@@ -38,6 +42,85 @@
 #define ENC_BASE_WIDTH_IN 9.2 // DOUBT, probably not accurate. TODO: re-measure
 #define BACK_TO_CENTER_IN 2.12 // Distance between back encoder and tracking center
 #define STARTING_Y_IN 8 // Distance between tracking center and wall when robot is placed back to wall TODO: measure this
+// Distance between tracking center and the center of a goal when the intake is pressed into it
+#define GOAL_CONTACT_IN (GOAL_RADIUS_IN / 2 + 9.25)
+// Distance between tracking center and a wall the robot is backed against
+#define WALL_CONTACT_IN STARTING_Y_IN
+
+/* Odometry calibration (see calibration.hpp) */
+#define CALIBRATION_LOG_FILE "/usd/calibration.csv"
+#define CALIBRATION_SAMPLE_MS 10
+// Number of samples compared at once. Longer windows average out encoder ticks and IMU lag
+#define CALIBRATION_WINDOW 5
+// Results further than this from the constants above are thrown away
+#define CALIBRATION_MAX_WIDTH_CHANGE_IN 3
+#define CALIBRATION_MAX_SCALE_CHANGE 0.1
+
+// Number of past poses odometry keeps for latency compensation. 2000 entries covers 2 seconds at the 1ms odometry rate
+#define ODOM_HISTORY_SIZE 2000
+
+/* Odometry velocity estimation (see velocityestimator.hpp) */
+#define ODOM_VEL_FILTER util::VelocityEstimator::SAVITZKY_GOLAY
+// How far back the Savitzky-Golay filter fits, in seconds. Time based, so the lag stays the same
+// whether odometry steps every 1ms or only when the tracking wheels change every 10ms
+#define ODOM_VEL_WINDOW_S 0.05
+// Positions the estimator keeps. Has to cover ODOM_VEL_WINDOW_S at the fastest step rate, 1ms
+#define ODOM_VEL_MAX_SAMPLES 64
+// Time constant of the EMA filter in seconds. Weighted by the real time between steps, so also independent of the rate
+#define ODOM_VEL_EMA_TIME_S 0.02
+
+// Number of reset/relocalize/configure commands that can wait for the odometry task at once
+#define ODOM_COMMAND_QUEUE_LENGTH 8
+// Milliseconds to wait for the odometry task to take or apply a command
+#define ODOM_COMMAND_TIMEOUT 50
+
+// When the odometry loop does its work. Odometry::FIXED, Odometry::ON_NEW_DATA or Odometry::PHASE_LOCKED
+#define ODOM_LOOP_MODE Odometry::ON_NEW_DATA
+// How often the ADI ports (tracking wheels) refresh, in milliseconds
+#define ODOM_ADI_PERIOD_MS 10
+// Longest time odometry goes without integrating when nothing changes, in microseconds
+#define ODOM_MAX_SKIP_US 20000
+
+// How odometry integrates each step. ArcIntegrator, ExpMapIntegrator or MidpointIntegrator (see odometrystep.hpp)
+#define ODOM_INTEGRATOR ArcIntegrator
+
+/* Drive motor odometry (see motorodometry.hpp) */
+// How often the drive motors report a new position, in microseconds
+#define ODOM_MOTOR_PERIOD_US 10000
+// Drive wheel steps longer than this are thrown away, in inches
+#define ODOM_MOTOR_MAX_STEP_IN 2
+// How far the robot has to move without a tracking wheel changing before it counts as unplugged, in inches
+#define ODOM_UNPLUGGED_TRAVEL_IN 3
+// Switch to the drive motor encoders while a tracking wheel is unplugged
+#define ODOM_MOTOR_FALLBACK true
+
+/* Wheel slip detection (see slipdetector.hpp) */
+// Wheel speed differences below this are encoder resolution, not slip, in inches per second
+#define SLIP_MIN_SPEED_IN_S 4
+// Time constant of the filter on the slip ratios, in seconds
+#define SLIP_EMA_TIME_S 0.03
+// Average slip ratio above which the robot is pushing into something
+#define SLIP_CONTACT_RATIO 0.6
+// The slip is still updated this often while the drive motors don't move, in microseconds
+#define SLIP_STALE_US 25000
+
+/* Odometry filter (EKF) */
+// Fuse the IMU, tracking wheels and drive motor encoders instead of picking one heading source.
+// Off until the noise values below are tuned on the robot, Odometry::useEKF turns it on at runtime
+#define ODOM_USE_EKF false
+// Variance added per inch a tracking wheel rolls, in square inches
+#define EKF_TRANSLATION_NOISE 0.0005
+// Variance added to the heading per radian turned (or per base width rolled), in square radians
+#define EKF_ROTATION_NOISE 0.0002
+// Variance added on every step, even when not moving
+#define EKF_STEP_NOISE 1e-9
+// How much the IMU heading is trusted, in square radians (about 0.5 degrees standard deviation)
+#define EKF_IMU_HEADING_VARIANCE 7.6e-5
+// How much the IMU yaw rate is trusted, in square radians per second squared (about 10 degrees per second standard
+// deviation). The rate is held between IMU updates, out of step with the tracking wheels, so one step's rate is rough
+#define EKF_IMU_RATE_VARIANCE 3e-2
+// How much the heading from the drive motors is trusted. Drive wheels slip a lot, so this is high
+#define EKF_DRIVE_HEADING_VARIANCE 3e-3
 
 // Distance between tracking center to a wheel
 #define WHEEL_TO_CENTER_IN 7.10633 //sqrt((chassiswidth/2)^2 + (chassislength/2)^2)
@@ -48,6 +131,29 @@
 // Max rotation speed of the chassis, in radians per second
 #define MAX_CHASSIS_RPS (MAX_SPEED_IN_S / WHEEL_TO_CENTER_IN) // around 7.6, which is around 1.2 rotations per second
 
+/* Drive feedforward (see feedforward.hpp) */
+// Gains used until the sysid routine measures them. Voltages are in millivolts, like moveVoltage
+#define DRIVE_FF_KS 500
+#define DRIVE_FF_KV ((12000 - DRIVE_FF_KS) / MAX_SPEED_IN_S) // Full voltage at full speed, like leftMoveRPM
+#define DRIVE_FF_KA 20
+// Below this wheel speed the static friction voltage is scaled down, so it doesn't chatter around 0
+#define FEEDFORWARD_STATIC_DEADBAND_IN_S 0.5
+// Drives AutoDrive's moves with the feedforward model and moveVoltage. false sends them through moveVelocity.
+// Off until the sysid routine has fitted the gains on the robot and they're in the SD card config
+#define AUTO_FEEDFORWARD false
+
+/* Drive system identification (see sysid.hpp) */
+#define SYSID_LOG_FILE "/usd/sysid.csv"
+#define SYSID_SAMPLE_MS 10
+#define SYSID_RAMP_MV_S 1500 // How fast the quasistatic test raises the voltage
+#define SYSID_STEP_MV 6000   // Voltage of the step test
+// Samples slower than this are left out, static friction makes them behave differently
+#define SYSID_MIN_VELOCITY_IN_S 1
+// Number of samples on each side used to find the acceleration
+#define SYSID_ACCEL_WINDOW 3
+// Results with a kV further than this fraction from DRIVE_FF_KV are thrown away
+#define SYSID_MAX_KV_CHANGE 0.5
+
 
 
 /* Automatic Driving Values */
@@ -78,6 +184,53 @@
 #define TURNING_ACCEL 5
 #define TURNING_DECEL 7
 
+// Motion profiles for driving to a point and turning.
+// util::MotionProfile::NONE (PID alone), TRAPEZOID or S_CURVE (see motionprofile.hpp)
+#define AUTO_PROFILE util::MotionProfile::S_CURVE
+#define PROFILE_MAX_VEL_IN_S MAX_SPEED_IN_S
+#define PROFILE_MAX_ACCEL_IN_S2 120
+#define PROFILE_MAX_JERK_IN_S3 1000
+#define PROFILE_MAX_TURN_RPS (MAX_CHASSIS_RPS * 0.75)
+#define PROFILE_MAX_TURN_ACCEL 20 // Radians per second squared
+#define PROFILE_MAX_TURN_JERK 200 // Radians per second cubed
+// How long a profiled move gets to reach its tolerance after the profile ends, in milliseconds
+#define PROFILE_SETTLE_MS 500
+
+// Trajectories that move and turn at the same time (see trajectory.hpp)
+#define TRAJECTORY_MAX_WHEEL_SPEED_IN_S (MAX_SPEED_IN_S * 0.9) // Leaves some room for the PID controllers to correct
+#define TRAJECTORY_MAX_WHEEL_ACCEL_IN_S2 120
+#define TRAJECTORY_SPACING_IN 0.5
+#define TRAJECTORY_MAX_PASSES 10 // Forward and backward speed passes before giving up on making every interval fit
+
+// Model predictive control of profiled moves and trajectories (see mpc.hpp). false uses the PID controllers
+#define AUTO_MPC false
+#define MPC_HORIZON 8       // Number of steps predicted
+#define MPC_STEP_S 0.04     // Seconds between predicted steps
+#define MPC_POSITION_WEIGHT 1
+#define MPC_HEADING_WEIGHT 100 // A radian off costs as much as 10 inches off
+#define MPC_EFFORT_WEIGHT 0.01
+#define MPC_MAX_ITERATIONS 40
+#define MPC_TOLERANCE_IN_S 0.05 // Stops iterating once no wheel speed changes by more than this
+#define MPC_MAX_SOLVE_US 5000   // Half the 10ms control period. A slower solve switches the move back to PID
+
+// Chained moves (see AutoDrive::driveThroughAsync)
+#define CHAIN_PASS_TOLERANCE_IN 4 // How close the robot has to get to a point it drives through
+
+// Pure pursuit path following
+#define PATH_MIN_LOOKAHEAD_IN 6
+#define PATH_MAX_LOOKAHEAD_IN 18
+#define PATH_LOOKAHEAD_GAIN 0.25 // Extra inches of lookahead per inch per second of speed
+#define PATH_MAX_LATERAL_ACCEL 60 // Inches per second squared, limits the speed in curves
+
+// Number of moves that can wait for the AutoDrive task at once. Also the longest chain driveThroughAsync takes
+#define AUTO_COMMAND_QUEUE_LENGTH 16
+// Milliseconds to wait for room in the AutoDrive queue
+#define AUTO_COMMAND_TIMEOUT 50
+// Contact isn't checked this long into a move, as the wheels slip when they speed up from a stop. In milliseconds
+#define AUTO_CONTACT_GRACE_MS 150
+// Fraction of full speed the robot keeps pushing at after contact with AutoSettings::CONTACT_CUT_POWER
+#define AUTO_CONTACT_POWER 0.3
+
 /* Controller Mappings */
 #define DEBUG_STRAIGHT      pros::E_CONTROLLER_DIGITAL_X
 #define DEBUG_SORTER_B      pros::E_CONTROLLER_DIGITAL_B
@@ -166,6 +319,13 @@
                         UPPER_ROLLER_MOTOR,   \
                         LOWER_ROLLER_MOTOR    \
                         }
+// Number of V5 smart ports
+#define SMART_PORT_COUNT 21
+// How often the telemetry task samples every motor in SELFCHECK_PORTS, in milliseconds
+#define TELEMETRY_PERIOD_MS 10
+// Longest time MotorCommander holds back an unchanged command, in milliseconds.
+// Resending now and then fixes up a motor that was moved some other way without telling MotorCommander
+#define MOTOR_COMMAND_REFRESH_MS 500
 
 // Debug settings
 #define GYRO_LCD_LINE 4
@@ -5,12 +5,18 @@
 #include "subsystem/drive.hpp"
 #include "subsystem/intake.hpp"
 #include "subsystem/selfcheck.hpp"
+#include "subsystem/telemetry.hpp"
+#include "subsystem/motorcommander.hpp"
+#include "subsystem/arbiter.hpp"
 #include "subsystem/heading.hpp"
 #include "subsystem/vision.hpp"
 
+extern ActuatorArbiter arbiter;
+extern MotorCommander motorCommander;
 extern DriveSubsystem drive;
 extern IntakeSubsystem intake;
 extern SelfCheck selfCheck;
+extern MotorTelemetry telemetry;
 
 extern HeadingSensor gyroSystem;
 
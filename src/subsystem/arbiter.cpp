@@ -0,0 +1,164 @@
+#include "arbiter.hpp"
+
+#include <cstdio>
+#include "profiles.hpp"
+#include "io.hpp"
+#include "subsystem.hpp"
+
+namespace {
+    const char *actuatorNames[ACTUATOR_COUNT] = {"drive", "intake", "lower roller", "upper roller"};
+
+    /// The index of the actuator a motor belongs to, -1 if none
+    int actuatorOf(int port) {
+        switch (port) {
+            case LEFT_FORWARD_MOTOR:
+            case RIGHT_FORWARD_MOTOR:
+            case LEFT_REAR_MOTOR:
+            case RIGHT_REAR_MOTOR:
+                return 0;
+            case LEFT_INTAKE_MOTOR:
+            case RIGHT_INTAKE_MOTOR:
+                return 1;
+#ifdef LOWER_ROLLER_MOTOR
+            case LOWER_ROLLER_MOTOR:
+                return 2;
+#endif
+#ifdef UPPER_ROLLER_MOTOR
+            case UPPER_ROLLER_MOTOR:
+                return 3;
+#endif
+            default:
+                return -1;
+        }
+    }
+}
+
+ActuatorArbiter::ActuatorArbiter() {
+    for (int &owner : owners)
+        owner = -1;
+    mutex = pros::c::mutex_create();
+}
+
+int ActuatorArbiter::updateOwners(char log[ACTUATOR_COUNT][100]) {
+    int lines = 0;
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        // Highest priority first, then the newest token
+        int best = -1;
+        for (int j = 0; j < ARBITER_MAX_LEASES; j++) {
+            const Lease &lease = leases[j];
+            if (lease.token == 0 || !(lease.actuators & (1 << i)))
+                continue;
+            if (best < 0 || lease.priority > leases[best].priority ||
+                (lease.priority == leases[best].priority && lease.token > leases[best].token))
+                best = j;
+        }
+        if (best == owners[i])
+            continue;
+
+        if (best < 0)
+            sprintf(log[lines++], "Arbiter: %s released by %s", actuatorNames[i], leases[owners[i]].name);
+        else if (owners[i] < 0)
+            sprintf(log[lines++], "Arbiter: %s acquired by %s", actuatorNames[i], leases[best].name);
+        else if (leases[owners[i]].token == 0)
+            sprintf(log[lines++], "Arbiter: %s released by %s, back to %s", actuatorNames[i], leases[owners[i]].name,
+                    leases[best].name);
+        else
+            sprintf(log[lines++], "Arbiter: %s taken from %s by %s", actuatorNames[i], leases[owners[i]].name,
+                    leases[best].name);
+        owners[i] = best;
+    }
+    return lines;
+}
+
+ActuatorToken ActuatorArbiter::acquire(unsigned actuators, int priority, const char *name) {
+    char log[ACTUATOR_COUNT][100];
+    int lines = 0;
+    ActuatorToken token = 0;
+
+    pros::c::mutex_take(mutex, TIMEOUT_MAX);
+    for (Lease &lease : leases) {
+        if (lease.token == 0) {
+            token = nextToken++;
+            lease = {token, pros::c::task_get_current(), priority, actuators, name};
+            lines = updateOwners(log);
+            break;
+        }
+    }
+    pros::c::mutex_give(mutex);
+
+    if (token == 0)
+        sprintf(log[lines++], "Arbiter: no room for %s, %d tokens are out", name, ARBITER_MAX_LEASES);
+    // Logged after giving the lock back, so writing to the SD card never holds up a motor command
+    for (int i = 0; i < lines; i++)
+        localStorage.log(log[i]);
+    return token;
+}
+
+void ActuatorArbiter::release(ActuatorToken token) {
+    if (token == 0)
+        return;
+    char log[ACTUATOR_COUNT][100];
+    int lines = 0;
+
+    pros::c::mutex_take(mutex, TIMEOUT_MAX);
+    for (Lease &lease : leases) {
+        if (lease.token == token) {
+            // The slot keeps its name until updateOwners has logged it, and only gets reused after that
+            lease.token = 0;
+            lines = updateOwners(log);
+            break;
+        }
+    }
+    pros::c::mutex_give(mutex);
+
+    for (int i = 0; i < lines; i++)
+        localStorage.log(log[i]);
+}
+
+void ActuatorArbiter::releaseAll(int maxPriority) {
+    char log[ACTUATOR_COUNT][100];
+    int lines = 0;
+
+    pros::c::mutex_take(mutex, TIMEOUT_MAX);
+    for (Lease &lease : leases)
+        if (lease.token != 0 && lease.priority <= maxPriority)
+            lease.token = 0;
+    lines = updateOwners(log);
+    pros::c::mutex_give(mutex);
+
+    for (int i = 0; i < lines; i++)
+        localStorage.log(log[i]);
+}
+
+unsigned ActuatorArbiter::held(ActuatorToken token) {
+    unsigned actuators = 0;
+    pros::c::mutex_take(mutex, TIMEOUT_MAX);
+    for (int i = 0; i < ACTUATOR_COUNT; i++)
+        if (owners[i] >= 0 && leases[owners[i]].token == token && token != 0)
+            actuators |= 1 << i;
+    pros::c::mutex_give(mutex);
+    return actuators;
+}
+
+bool ActuatorArbiter::allows(int port) {
+    int actuator = actuatorOf(port);
+    if (actuator < 0)
+        return true;
+    pros::c::mutex_take(mutex, TIMEOUT_MAX);
+    int owner = owners[actuator];
+    bool allowed = owner < 0 || leases[owner].task == pros::c::task_get_current();
+    pros::c::mutex_give(mutex);
+    return allowed;
+}
+
+ActuatorLease::ActuatorLease(unsigned actuators, int priority, const char *name) {
+    token = arbiter.acquire(actuators, priority, name);
+}
+
+ActuatorLease::~ActuatorLease() {
+    arbiter.release(token);
+}
+
+bool ActuatorLease::holdsAny() {
+    return arbiter.held(token) != 0;
+}
@@ -0,0 +1,127 @@
+#ifndef _ARBITER_HPP_INCLUDED
+#define _ARBITER_HPP_INCLUDED
+
+#include "api.h"
+
+#define ACTUATOR_COUNT 4
+#define ARBITER_MAX_LEASES 8
+
+/// The groups of motors that are handed out as a whole. Combined with |
+enum Actuator : unsigned {
+    ACTUATOR_DRIVE = 1 << 0,
+    ACTUATOR_INTAKE = 1 << 1,
+    ACTUATOR_LOWER_ROLLER = 1 << 2,
+    ACTUATOR_UPPER_ROLLER = 1 << 3
+};
+
+/// Who wins when two tasks want the same actuator. Equal priorities go to whoever asked last.
+enum ArbiterPriority {
+    ARBITER_PRIORITY_BACKGROUND = 0, // Jobs running alongside the routine, like the indexer's
+    ARBITER_PRIORITY_ROUTINE = 1,    // The auton routine and AutoDrive
+    ARBITER_PRIORITY_DRIVER = 2,     // Driver control, held by opcontrol
+    ARBITER_PRIORITY_TUNING = 3      // Calibration routines started from the menu, which drive the robot during opcontrol
+};
+
+/// Names one call to ActuatorArbiter::acquire. 0 is never handed out.
+typedef uint32_t ActuatorToken;
+
+/**
+ * Decides which task gets to move each actuator, so jobs running at the same time don't fight over the motors.
+ *
+ * A task acquires the actuators it needs with a priority and gets a token. Each actuator belongs to the highest
+ * priority token that wants it. MotorCommander drops commands from other tasks, so a job that lost an actuator
+ * can't move it anymore, even if it doesn't check. When a token is released, what it had goes back to the next token
+ * in line, like a background job that was preempted for a moment. Every change of owner is logged.
+ *
+ * Actuators no token wants can be moved by any task, like before.
+ */
+class ActuatorArbiter {
+private:
+    struct Lease {
+        ActuatorToken token;  // 0 if the slot is free
+        pros::task_t task;    // The task whose commands get through
+        int priority;
+        unsigned actuators;   // Actuator flags it asked for
+        const char *name;     // For the log
+    };
+    Lease leases[ARBITER_MAX_LEASES] = {};
+    int owners[ACTUATOR_COUNT]; // Index into leases, -1 if nobody wants the actuator
+    ActuatorToken nextToken = 1;
+    pros::mutex_t mutex;
+
+    /**
+     * Hands each actuator to the lease that should have it. The lock has to be held.
+     *
+     * \param log Filled with a line for every actuator that changed owner, to be logged once the lock is given back.
+     *
+     * \return The number of lines written.
+     */
+    int updateOwners(char log[ACTUATOR_COUNT][100]);
+
+public:
+    /// Creates the lock. Constructed with the other globals, before any task can acquire anything.
+    ActuatorArbiter();
+
+    /**
+     * Asks for actuators. Takes them from lower priority tokens right away, and waits in line behind higher
+     * priority ones without blocking. Check what it got with held().
+     *
+     * \param actuators The Actuator flags.
+     *
+     * \param priority An ArbiterPriority.
+     *
+     * \param name Shown in the log. Has to outlive the token, e.g. a string literal.
+     *
+     * \return The token to release, or 0 if ARBITER_MAX_LEASES tokens are already out.
+     */
+    ActuatorToken acquire(unsigned actuators, int priority, const char *name);
+
+    /**
+     * Gives the actuators back, handing them to the next token in line. Does nothing for 0.
+     *
+     * \param token The token from acquire.
+     */
+    void release(ActuatorToken token);
+
+    /**
+     * Releases every token up to a priority, whichever task it belongs to. Used when the competition switch changes
+     * modes, as a task that was stopped never gets to release what it held.
+     *
+     * \param maxPriority The highest ArbiterPriority to release.
+     */
+    void releaseAll(int maxPriority);
+
+    /**
+     * \param token The token from acquire.
+     *
+     * \return The Actuator flags the token owns right now. 0 once it was preempted from everything or released.
+     */
+    unsigned held(ActuatorToken token);
+
+    /**
+     * Checks if the current task can command the motor on a port. Used by MotorCommander.
+     *
+     * \param port The smart port.
+     *
+     * \return True if the motor isn't part of an actuator, nobody wants its actuator, or its owner is this task.
+     */
+    bool allows(int port);
+};
+
+/**
+ * Acquires actuators for as long as it's in scope, so every way out of a function releases them.
+ */
+class ActuatorLease {
+public:
+    ActuatorToken token;
+
+    /// See ActuatorArbiter::acquire.
+    ActuatorLease(unsigned actuators, int priority, const char *name);
+    ~ActuatorLease();
+    ActuatorLease(const ActuatorLease&) = delete;
+    ActuatorLease& operator=(const ActuatorLease&) = delete;
+
+    /// \return True if the lease still owns at least one of its actuators.
+    bool holdsAny();
+};
+#endif /* _ARBITER_HPP_INCLUDED */
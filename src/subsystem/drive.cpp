@@ -5,6 +5,7 @@
 
 #include "util/util.hpp"
 #include "io.hpp"
+#include "subsystem.hpp"
 #include "profiles.hpp"
 
 #define lfm leftFwdMtr
@@ -12,6 +13,13 @@
 #define lrm leftRearMtr
 #define rrm rightRearMtr
 
+namespace {
+    /// One value of a drive motor from the telemetry table, flipped for reversed motors like okapi does
+    double driveReading(int port, bool reversed, double MotorSample::*value) {
+        return telemetry.get(port).*value * (reversed ? -1 : 1);
+    }
+}
+
 DriveSubsystem::DriveSubsystem() : IK({0, 0}) {
     initDriveCurveLookup();
     coast();
@@ -63,12 +71,45 @@ void DriveSubsystem::setChassisSpeedIK(util::ChassisSpeed cs, double maxMotorSpe
     setWheelSpeed(IK.toWheelSpeed(cs, {0,0}).normalize(MAX_SPEED_IN_S * maxMotorSpeedMultiplier), 200 / MAX_SPEED_IN_S);
 }
 
+void DriveSubsystem::setChassisSpeedFF(util::ChassisSpeed velocity, util::ChassisSpeed acceleration, double maxMotorSpeedMultiplier) {
+    double maxSpeed = MAX_SPEED_IN_S * std::clamp(maxMotorSpeedMultiplier, 0.0, 1.0);
+    util::WheelSpeed wheelVel = IK.toWheelSpeed(velocity, {0,0});
+    util::WheelSpeed wheelAccel = IK.toWheelSpeed(acceleration, {0,0});
+
+    // Slows the acceleration down by as much as normalizing slows the wheels down
+    double fastest = std::max({fabs(wheelVel.lf), fabs(wheelVel.lr), fabs(wheelVel.rf), fabs(wheelVel.rr)});
+    if (fastest > maxSpeed) {
+        double scale = maxSpeed / fastest;
+        wheelAccel = {wheelAccel.lf * scale, wheelAccel.lr * scale, wheelAccel.rf * scale, wheelAccel.rr * scale};
+    }
+    setWheelSpeedFF(wheelVel.normalize(maxSpeed), wheelAccel);
+}
+
+void DriveSubsystem::setWheelSpeedFF(util::WheelSpeed velocity, util::WheelSpeed acceleration) {
+    setWheelVoltage({getFeedforward(0).calculate(velocity.lf, acceleration.lf),
+                     getFeedforward(1).calculate(velocity.lr, acceleration.lr),
+                     getFeedforward(2).calculate(velocity.rf, acceleration.rf),
+                     getFeedforward(3).calculate(velocity.rr, acceleration.rr)});
+}
+
+void DriveSubsystem::setWheelVoltage(util::WheelSpeed millivolts) {
+    motorCommander.apply(MotorCommander::VOLTAGE,
+                         {{lfm, millivolts.lf}, {lrm, millivolts.lr}, {rfm, millivolts.rf}, {rrm, millivolts.rr}});
+}
+
+util::Feedforward DriveSubsystem::getFeedforward(int wheel) {
+    return util::Feedforward({robotConfigs.driveKS[wheel], robotConfigs.driveKV[wheel], robotConfigs.driveKA[wheel]});
+}
+
+Eigen::Matrix<double, 4, 3> DriveSubsystem::getIKMatrix() {
+    return IK.getMatrix({0,0});
+}
 
 void DriveSubsystem::setWheelSpeed(util::WheelSpeed wheelSpeed, double multiplier) {
-    lfm.moveVelocity(wheelSpeed.lf * multiplier);
-    lrm.moveVelocity(wheelSpeed.lr * multiplier);
-    rfm.moveVelocity(wheelSpeed.rf * multiplier);
-    rrm.moveVelocity(wheelSpeed.rr * multiplier);
+    // All four wheels together, so the left and right sides never run a tick apart
+    motorCommander.apply(MotorCommander::VELOCITY,
+                         {{lfm, wheelSpeed.lf * multiplier}, {lrm, wheelSpeed.lr * multiplier},
+                          {rfm, wheelSpeed.rf * multiplier}, {rrm, wheelSpeed.rr * multiplier}});
 }
 
 void DriveSubsystem::coast() {
@@ -83,29 +124,51 @@ void DriveSubsystem::hold() {
     driveMtrGrp.setBrakeMode(okapi::AbstractMotor::brakeMode::hold);
 }
 
+// The readers below use the telemetry table like getStalling, so the odometry task, AutoDrive and sysid don't each
+// read the same smart ports again. The motors only report new values every 10ms, as often as the table refreshes
 double DriveSubsystem::getLeftEnc() {
-    return util::avgDouble(lfm.getPosition(), lrm.getPosition()) / 900.0 * 360.0;
+    return util::avgDouble(driveReading(LEFT_FORWARD_MOTOR, LEFT_FORWARD_MOTOR_REVERSED, &MotorSample::position),
+                           driveReading(LEFT_REAR_MOTOR, LEFT_REAR_MOTOR_REVERSED, &MotorSample::position)) / 900.0 * 360.0;
 }
 double DriveSubsystem::getRightEnc() {
-    return util::avgDouble(rfm.getPosition(), rrm.getPosition()) / 900.0 * 360.0;
+    return util::avgDouble(driveReading(RIGHT_FORWARD_MOTOR, RIGHT_FORWARD_MOTOR_REVERSED, &MotorSample::position),
+                           driveReading(RIGHT_REAR_MOTOR, RIGHT_REAR_MOTOR_REVERSED, &MotorSample::position)) / 900.0 * 360.0;
+}
+util::WheelSpeed DriveSubsystem::getWheelDistances() {
+    return {driveReading(LEFT_FORWARD_MOTOR, LEFT_FORWARD_MOTOR_REVERSED, &MotorSample::position) * DRIVE_ENC_TO_IN,
+            driveReading(LEFT_REAR_MOTOR, LEFT_REAR_MOTOR_REVERSED, &MotorSample::position) * DRIVE_ENC_TO_IN,
+            driveReading(RIGHT_FORWARD_MOTOR, RIGHT_FORWARD_MOTOR_REVERSED, &MotorSample::position) * DRIVE_ENC_TO_IN,
+            driveReading(RIGHT_REAR_MOTOR, RIGHT_REAR_MOTOR_REVERSED, &MotorSample::position) * DRIVE_ENC_TO_IN};
+}
+util::WheelSpeed DriveSubsystem::getWheelVelocities() {
+    // RPM to degrees per second, then to inches
+    return {driveReading(LEFT_FORWARD_MOTOR, LEFT_FORWARD_MOTOR_REVERSED, &MotorSample::velocity) * 6 * DRIVE_ENC_TO_IN,
+            driveReading(LEFT_REAR_MOTOR, LEFT_REAR_MOTOR_REVERSED, &MotorSample::velocity) * 6 * DRIVE_ENC_TO_IN,
+            driveReading(RIGHT_FORWARD_MOTOR, RIGHT_FORWARD_MOTOR_REVERSED, &MotorSample::velocity) * 6 * DRIVE_ENC_TO_IN,
+            driveReading(RIGHT_REAR_MOTOR, RIGHT_REAR_MOTOR_REVERSED, &MotorSample::velocity) * 6 * DRIVE_ENC_TO_IN};
 }
 double DriveSubsystem::getLeftVel() {
-    return util::avgDouble(lfm.getActualVelocity(), lrm.getActualVelocity());
+    return util::avgDouble(driveReading(LEFT_FORWARD_MOTOR, LEFT_FORWARD_MOTOR_REVERSED, &MotorSample::velocity),
+                           driveReading(LEFT_REAR_MOTOR, LEFT_REAR_MOTOR_REVERSED, &MotorSample::velocity));
 }
 double DriveSubsystem::getRightVel() {
-    return util::avgDouble(rfm.getActualVelocity(), rrm.getActualVelocity());
+    return util::avgDouble(driveReading(RIGHT_FORWARD_MOTOR, RIGHT_FORWARD_MOTOR_REVERSED, &MotorSample::velocity),
+                           driveReading(RIGHT_REAR_MOTOR, RIGHT_REAR_MOTOR_REVERSED, &MotorSample::velocity));
 }
 bool DriveSubsystem::leftMoveRPM(double speed) {
-    leftMtrGrp.moveVoltage(speed / 200.0 * 12000.0);
+    double millivolts = speed / 200.0 * 12000.0;
+    motorCommander.apply(MotorCommander::VOLTAGE, {{lfm, millivolts}, {lrm, millivolts}});
     return true;
 }
 
 void DriveSubsystem::moveRPM(double speed) {
-    driveMtrGrp.moveVoltage(speed / 200.0 * 12000.0);
+    double millivolts = speed / 200.0 * 12000.0;
+    motorCommander.apply(MotorCommander::VOLTAGE, {{lfm, millivolts}, {lrm, millivolts}, {rfm, millivolts}, {rrm, millivolts}});
 }
 
 bool DriveSubsystem::rightMoveRPM(double speed) {
-    rightMtrGrp.moveVoltage(speed / 200.0 * 12000.0);
+    double millivolts = speed / 200.0 * 12000.0;
+    motorCommander.apply(MotorCommander::VOLTAGE, {{rfm, millivolts}, {rrm, millivolts}});
     return true;
 }
 
@@ -114,8 +177,11 @@ void DriveSubsystem::resetEncoders() {
 }
 
 bool DriveSubsystem::getStalling() {
-    return  (lfm.getTorque() > DRIVE_STALL_TORQUE && abs(lrm.getActualVelocity()) < DRIVE_STALL_VELOCITY) ||
-            (lrm.getTorque() > DRIVE_STALL_TORQUE && abs(lrm.getActualVelocity()) < DRIVE_STALL_VELOCITY) ||
-            (rfm.getTorque() > DRIVE_STALL_TORQUE && abs(rfm.getActualVelocity()) < DRIVE_STALL_VELOCITY) ||
-            (rrm.getTorque() > DRIVE_STALL_TORQUE && abs(rrm.getActualVelocity()) < DRIVE_STALL_VELOCITY);
+    // Read from the telemetry table, so this doesn't cost any smart port reads of its own
+    for (int port : {LEFT_FORWARD_MOTOR, LEFT_REAR_MOTOR, RIGHT_FORWARD_MOTOR, RIGHT_REAR_MOTOR}) {
+        MotorSample motor = telemetry.get(port);
+        if (motor.connected && motor.torque > DRIVE_STALL_TORQUE && std::fabs(motor.velocity) < DRIVE_STALL_VELOCITY)
+            return true;
+    }
+    return false;
 }
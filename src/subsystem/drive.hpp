@@ -2,6 +2,7 @@
 #define _DRIVE_HPP_INCLUDED
 
 #include "util/math/drivekinematics.hpp"
+#include "util/math/feedforward.hpp"
 
 #define MANUAL_DRIVE_CURVATURE 2
 #define HOLD_TOLERANCE 3
@@ -35,6 +36,9 @@ class DriveSubsystem {
      */
     int lookupDriveCurve(int8_t input);
     util::InverseKinematics IK;
+
+    /// \return The feedforward model of one wheel, with the gains from robotConfigs. 0 to 3 for lf, lr, rf, rr.
+    util::Feedforward getFeedforward(int wheel);
     
 public:
     DriveSubsystem();
@@ -72,6 +76,38 @@ class DriveSubsystem {
      */
     void setChassisSpeedIK(util::ChassisSpeed cs, double maxMotorSpeedMultiplier = 1);
 
+    /**
+     * Applies a chassis speed and acceleration to the robot through the feedforward model of each wheel.
+     * Like setChassisSpeedIK, but the motors are driven with the voltage the move needs instead of moveVelocity.
+     * The acceleration is scaled down along with the speed if the speed has to be normalized.
+     * 
+     * \param velocity the target chassis speed relative to the robot, in inches and radians per second.
+     * 
+     * \param acceleration the target chassis acceleration relative to the robot, in inches and radians per second squared.
+     * 
+     * \param maxMotorSpeedMultiplier The maximum speed coefficient a motor should move at. Can be between 0 and 1
+     */
+    void setChassisSpeedFF(util::ChassisSpeed velocity, util::ChassisSpeed acceleration, double maxMotorSpeedMultiplier = 1);
+
+    /**
+     * Drives each wheel with the voltage its feedforward model gives for a velocity and acceleration.
+     * 
+     * \param velocity the target wheel speeds in inches per second. Not normalized.
+     * 
+     * \param acceleration the target wheel accelerations in inches per second squared.
+     */
+    void setWheelSpeedFF(util::WheelSpeed velocity, util::WheelSpeed acceleration);
+
+    /**
+     * Applies a voltage to each drive motor, without any model or controller in between.
+     * 
+     * \param millivolts the voltage of each wheel, between -12000 and 12000.
+     */
+    void setWheelVoltage(util::WheelSpeed millivolts);
+
+    ///\return The inverse kinematics matrix setChassisSpeedIK uses, for planning trajectories within the wheel limits.
+    Eigen::Matrix<double, 4, 3> getIKMatrix();
+
     ///Reacts to controller input and updates motor speeds accordingly. Should be called on every loop in opcontrol.
     void handleDriver();
 
@@ -81,6 +117,12 @@ class DriveSubsystem {
     ///\return The average encoder values from the integrated encoders from the two right motors.
     double getRightEnc();
 
+    ///\return The distance each drive wheel has rolled since the encoders were last reset, in inches.
+    util::WheelSpeed getWheelDistances();
+
+    ///\return The actual velocity of each drive wheel in inches per second.
+    util::WheelSpeed getWheelVelocities();
+
     ///\return The average actual velocity of the two left motors.
     double getLeftVel();
 
@@ -39,3 +39,10 @@ double HeadingSensor::getDegrees() {
     else
         return r2d(util::wrapAngle(d2r(gyro->getRemapped(360, -360))));
 }
+
+double HeadingSensor::getRate() {
+    if(!useInertialSensor)
+        return NAN;
+    // The z rate turns counterclockwise positive, the opposite way from the heading
+    return -inertialSensor->get_gyro_rate().z;
+}
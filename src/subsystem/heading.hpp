@@ -23,6 +23,13 @@ class HeadingSensor {
 	 */
     double getDegrees();
 
+    /**
+     * Gets how fast the heading is changing.
+     *
+     * \return Degrees per second, positive clockwise like getDegrees. NAN with the ADI gyro, which doesn't report it.
+     */
+    double getRate();
+
     /// Prints the value of the sensor to the screen. Meant to be called on a loop.
     void debug();
 
@@ -3,6 +3,7 @@
 #include "okapi/api.hpp"
 #include "profiles.hpp"
 #include "io.hpp"
+#include "subsystem.hpp"
 
 IntakeSubsystem::IntakeSubsystem() {
     coast();
@@ -11,23 +12,23 @@ IntakeSubsystem::IntakeSubsystem() {
 void IntakeSubsystem::handleDriver() {
     if (controllerMaster.getBtnRaw(INTAKE_OUT)) {
         flag = 0;
-        intakeMtrGrp.moveVoltage(speed);
+        moveVoltage(speed);
     }
     else if (controllerMaster.getBtnRaw(INTAKE_IN)) {
         flag = 0;
-        intakeMtrGrp.moveVoltage(0 - speed);
+        moveVoltage(0 - speed);
     }
     // Hold intake
     else if (flag == 0) {
         flag = -1;
         //Sets the voltake to 0 first to immidietly stop moving
         //From our testing, the velocity PID seems like it might have some latency.
-        intakeMtrGrp.moveVoltage(0);
-        intakeMtrGrp.moveVelocity(0);
+        moveVoltage(0);
+        moveVelocity(0);
     }
-    // Brake intake
+    // Brake intake. Only reaches the motors again every MOTOR_COMMAND_REFRESH_MS, since nothing changes
     else if (flag == -1) {
-        intakeMtrGrp.moveVelocity(0);
+        moveVelocity(0);
     }
 }
 
@@ -46,12 +47,14 @@ void IntakeSubsystem::hold() {
 void IntakeSubsystem::moveRelative(double iposition, std::int32_t ivelocity) {
     flag = 1;
     intakeMtrGrp.moveRelative(iposition, ivelocity);
+    motorCommander.invalidate(leftIntakeMtr);
+    motorCommander.invalidate(rightIntakeMtr);
 }
 
 void IntakeSubsystem::moveVoltage(int voltage) {
-    intakeMtrGrp.moveVoltage(voltage);
+    motorCommander.apply(MotorCommander::VOLTAGE, {{leftIntakeMtr, (double)voltage}, {rightIntakeMtr, (double)voltage}});
 }
 
 void IntakeSubsystem::moveVelocity(int velocity) {
-    intakeMtrGrp.moveVelocity(velocity);
+    motorCommander.apply(MotorCommander::VELOCITY, {{leftIntakeMtr, (double)velocity}, {rightIntakeMtr, (double)velocity}});
 }
@@ -0,0 +1,85 @@
+#include "motorcommander.hpp"
+
+#include "subsystem.hpp"
+
+MotorCommander::MotorCommander() {
+    mutex = pros::c::mutex_create();
+}
+
+void MotorCommander::rollWindow(uint32_t now) {
+    if (now - windowStart < 1000)
+        return;
+    // Every command rolls the window first, so the counts are all from the second that just ended.
+    // Nothing was sent in the second before this one if that's longer ago
+    bool quiet = now - windowStart >= 2000;
+    for (PortState &port : ports) {
+        port.stats.writesPerSecond = quiet ? 0 : port.writes;
+        port.stats.suppressedPerSecond = quiet ? 0 : port.suppressed;
+        port.writes = port.suppressed = 0;
+    }
+    windowStart = now;
+}
+
+void MotorCommander::write(okapi::Motor &motor, Mode mode, double value, uint32_t now) {
+    int port = motor.getPort();
+    if (port < 1 || port > SMART_PORT_COUNT)
+        return;
+    PortState &state = ports[port - 1];
+    if (!arbiter.allows(port)) {
+        state.stats.totalBlocked++;
+        return;
+    }
+
+    // okapi takes 16 bit commands, so compare what it would actually send
+    int16_t command = (int16_t)value;
+    if (state.mode == mode && state.value == command && now - state.lastWrite < MOTOR_COMMAND_REFRESH_MS) {
+        state.suppressed++;
+        return;
+    }
+
+    if (mode == VOLTAGE)
+        motor.moveVoltage(command);
+    else
+        motor.moveVelocity(command);
+    state.mode = mode;
+    state.value = command;
+    state.lastWrite = now;
+    state.writes++;
+    state.stats.totalWrites++;
+}
+
+void MotorCommander::moveVoltage(okapi::Motor &motor, int millivolts) {
+    apply(VOLTAGE, {{motor, (double)millivolts}});
+}
+
+void MotorCommander::moveVelocity(okapi::Motor &motor, int velocity) {
+    apply(VELOCITY, {{motor, (double)velocity}});
+}
+
+void MotorCommander::apply(Mode mode, std::initializer_list<MotorCommand> commands) {
+    pros::c::mutex_take(mutex, TIMEOUT_MAX);
+    uint32_t now = pros::millis();
+    rollWindow(now);
+    for (const MotorCommand &command : commands)
+        write(command.motor, mode, command.value, now);
+    pros::c::mutex_give(mutex);
+}
+
+void MotorCommander::invalidate(okapi::Motor &motor) {
+    int port = motor.getPort();
+    if (port < 1 || port > SMART_PORT_COUNT)
+        return;
+    pros::c::mutex_take(mutex, TIMEOUT_MAX);
+    ports[port - 1].mode = NONE;
+    pros::c::mutex_give(mutex);
+}
+
+MotorCommandStats MotorCommander::getStats(int port) {
+    if (port < 1 || port > SMART_PORT_COUNT)
+        return {};
+    pros::c::mutex_take(mutex, TIMEOUT_MAX);
+    rollWindow(pros::millis());
+    MotorCommandStats stats = ports[port - 1].stats;
+    pros::c::mutex_give(mutex);
+    return stats;
+}
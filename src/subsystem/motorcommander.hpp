@@ -0,0 +1,105 @@
+#ifndef _MOTORCOMMANDER_HPP_INCLUDED
+#define _MOTORCOMMANDER_HPP_INCLUDED
+
+#include <initializer_list>
+#include "api.h"
+#include "okapi/api.hpp"
+#include "profiles.hpp"
+
+/// How many commands one port got, to keep an eye on the load on the smart port bus.
+struct MotorCommandStats {
+    uint32_t writesPerSecond;     // Commands sent to the motor in the last full second
+    uint32_t suppressedPerSecond; // Commands held back in the last full second because nothing changed
+    uint32_t totalWrites;         // Commands sent since the program started
+    uint32_t totalBlocked;        // Commands dropped because another task owns the motor, see ActuatorArbiter
+};
+
+/// One motor and what to set it to, for MotorCommander::apply.
+struct MotorCommand {
+    okapi::Motor &motor;
+    double value; // Millivolts or rpm, depending on the mode
+};
+
+/**
+ * Sits between the subsystems and the motors, so every voltage and velocity command goes through one place.
+ *
+ * Holds back commands that wouldn't change anything, like the intake being told to stop every 20ms while braking.
+ * Unchanged commands are still resent every MOTOR_COMMAND_REFRESH_MS in case a motor was moved some other way.
+ * Commands for several motors, like the four drive wheels, are applied under one lock so commands from other tasks
+ * can't land in between them. Commands for motors another task owns through ActuatorArbiter are dropped.
+ */
+class MotorCommander {
+public:
+    enum Mode : uint8_t {
+        NONE,     // Nothing sent yet, or moved some other way since
+        VOLTAGE,  // okapi::Motor::moveVoltage, in millivolts
+        VELOCITY  // okapi::Motor::moveVelocity, in rpm
+    };
+
+private:
+    /// The last command sent to one port.
+    struct PortState {
+        Mode mode;
+        int16_t value;
+        uint32_t lastWrite; // pros::millis() when it was sent
+        uint32_t writes, suppressed; // In the current second
+        MotorCommandStats stats;
+    };
+    PortState ports[SMART_PORT_COUNT] = {}; // Indexed by port - 1
+    uint32_t windowStart = 0;
+    pros::mutex_t mutex = NULL;
+
+    /// Sends the command if the task may move the motor and it changes anything. The lock has to be held
+    void write(okapi::Motor &motor, Mode mode, double value, uint32_t now);
+
+    /// Starts a new second for the stats if the last one is over. The lock has to be held
+    void rollWindow(uint32_t now);
+
+public:
+    /// Creates the lock. Constructed with the other globals, before any task can send a command.
+    MotorCommander();
+
+    /**
+     * Sets the voltage of a motor, if it isn't already set to it.
+     *
+     * \param motor The motor.
+     *
+     * \param millivolts The new voltage from -12000 to 12000.
+     */
+    void moveVoltage(okapi::Motor &motor, int millivolts);
+
+    /**
+     * Sets the velocity of a motor, if it isn't already set to it.
+     *
+     * \param motor The motor.
+     *
+     * \param velocity The new velocity in rpm, within the motor's gearset.
+     */
+    void moveVelocity(okapi::Motor &motor, int velocity);
+
+    /**
+     * Applies a command to each motor in one go. No other command goes out in between, so e.g. the left and right
+     * sides of the drive always get their commands together.
+     *
+     * \param mode VOLTAGE or VELOCITY.
+     *
+     * \param commands The motors and what to set them to.
+     */
+    void apply(Mode mode, std::initializer_list<MotorCommand> commands);
+
+    /**
+     * Forgets the last command sent to a motor, so the next one is always sent.
+     * Call after moving the motor some other way, like okapi::Motor::moveRelative.
+     *
+     * \param motor The motor.
+     */
+    void invalidate(okapi::Motor &motor);
+
+    /**
+     * \param port The smart port, 1 to 21.
+     *
+     * \return How many commands the port got.
+     */
+    MotorCommandStats getStats(int port);
+};
+#endif /* _MOTORCOMMANDER_HPP_INCLUDED */
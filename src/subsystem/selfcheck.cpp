@@ -1,6 +1,5 @@
 #include "selfcheck.hpp"
 
-#include <climits>
 #include <cstdio>
 #include "profiles.hpp"
 #include "io.hpp"
@@ -13,8 +12,7 @@
  * 
  * This is to prevent disconnected motors from clogging up the "highest temperature motor" display.
  */
-#define MOTOR_TEMP pros::c::motor_get_temperature(port)>100?0:pros::c::motor_get_temperature(port)
-#define MOTOR_FAULT pros::c::motor_get_faults(port)
+#define MOTOR_TEMP(motor) (motor.temperature>100?0:motor.temperature)
 
 SelfCheck::SelfCheck(std::vector<int> portsUsed) {
 	ports = portsUsed;
@@ -27,7 +25,9 @@ void selfCheckTaskFn(void *param) {
 		bool errFlag = false;
 		int maxTemp = 0, maxPort = 0;
 		for(int port:selfCheck.ports) {
-			double curTemp = MOTOR_TEMP; // Store temperature because motors dont like being polled too quick
+			// Read from the telemetry table instead of the motor, which the telemetry task already polls
+			MotorSample motor = telemetry.get(port);
+			double curTemp = MOTOR_TEMP(motor);
 
 			if(curTemp >= maxTemp) {
 				maxTemp = curTemp;
@@ -36,7 +36,7 @@ void selfCheckTaskFn(void *param) {
 
 			bool error = true;
 
-			if(MOTOR_FAULT==INT_MAX)
+			if(!motor.connected)
 				//motor's not connected!
 				sprintf(strBuf, "Port %d DISCON  ", port);
 			else if(curTemp >= MOTOR_OVERHEAT_TEMP)
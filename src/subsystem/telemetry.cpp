@@ -0,0 +1,99 @@
+#include "telemetry.hpp"
+
+#include <algorithm>
+#include "profiles.hpp"
+#include "util/util.hpp"
+
+MotorTelemetry::MotorTelemetry(std::vector<int> portsUsed) {
+    ports = portsUsed;
+}
+
+void MotorTelemetry::telemetryTaskFn(void *param) {
+    MotorTelemetry *telemetry = (MotorTelemetry*) param;
+    TelemetryStats stats = {};
+    uint32_t now = pros::millis();
+    while (true) {
+        uint64_t start = util::micros();
+        telemetry->sample();
+        uint32_t time = util::micros() - start;
+
+        stats.cycles++;
+        stats.lastMicros = time;
+        stats.worstMicros = std::max(stats.worstMicros, time);
+        stats.averageMicros += (time - stats.averageMicros) / stats.cycles;
+        stats.retries = telemetry->retries;
+        telemetry->stats.write(stats);
+
+        pros::Task::delay_until(&now, TELEMETRY_PERIOD_MS);
+    }
+}
+
+void MotorTelemetry::sample() {
+    uint32_t current = published.load(std::memory_order_relaxed);
+    // Keeps the writes below from being seen before the last flip, when readers could still be on this buffer
+    std::atomic_thread_fence(std::memory_order_release);
+    Table &table = buffers[(current + 1) % 2];
+    table.timestamp = util::micros();
+    for (int port : ports) {
+        if (port < 1 || port > SMART_PORT_COUNT)
+            continue;
+        MotorSample &motor = table.motors[port - 1];
+        motor.faults = pros::c::motor_get_faults(port);
+        motor.connected = motor.faults != PROS_ERR;
+        if (!motor.connected) {
+            motor = {0, 0, 0, 0, 0, 0, motor.faults, false};
+            continue;
+        }
+        motor.position = pros::c::motor_get_position(port);
+        motor.velocity = pros::c::motor_get_actual_velocity(port);
+        motor.torque = pros::c::motor_get_torque(port);
+        motor.temperature = pros::c::motor_get_temperature(port);
+        motor.current = pros::c::motor_get_current_draw(port);
+        motor.voltage = pros::c::motor_get_voltage(port);
+    }
+    published.store(current + 1, std::memory_order_release);
+}
+
+void MotorTelemetry::startTask() {
+    if (!taskRunning) {
+        taskRunning = true;
+        telemetryTask = pros::c::task_create(telemetryTaskFn, this, TASK_PRIORITY_DEFAULT,
+                                             TASK_STACK_DEPTH_DEFAULT, "Telemetry Task");
+    }
+}
+
+void MotorTelemetry::endTask() {
+    if (taskRunning) {
+        pros::c::task_delete(telemetryTask);
+        taskRunning = false;
+    }
+}
+
+MotorSample MotorTelemetry::get(int port) {
+    if (port < 1 || port > SMART_PORT_COUNT)
+        return {};
+    while (true) {
+        uint32_t before = published.load(std::memory_order_acquire);
+        MotorSample sample = buffers[before % 2].motors[port - 1];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // The task only writes to this buffer again after flipping away from it
+        if (published.load(std::memory_order_relaxed) == before)
+            return sample;
+        retries.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+uint64_t MotorTelemetry::getTimestamp() {
+    while (true) {
+        uint32_t before = published.load(std::memory_order_acquire);
+        uint64_t timestamp = buffers[before % 2].timestamp;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (published.load(std::memory_order_relaxed) == before)
+            return timestamp;
+        retries.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+TelemetryStats MotorTelemetry::getStats() {
+    return stats.read();
+}
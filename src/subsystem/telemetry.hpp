@@ -0,0 +1,87 @@
+#ifndef _TELEMETRY_HPP_INCLUDED
+#define _TELEMETRY_HPP_INCLUDED
+
+#include <atomic>
+#include <vector>
+#include "api.h"
+#include "profiles.hpp"
+#include "util/seqlock.hpp"
+
+/// Everything read from one motor in one telemetry cycle.
+struct MotorSample {
+    // As the motor itself turns. okapi reverses motors in software, so these aren't flipped for reversed motors
+    double position;    // In the motor's encoder units
+    double velocity;    // Rpm
+    double torque;      // Nm
+    double temperature; // Celsius
+    int32_t current;    // mA
+    int32_t voltage;    // mV
+    uint32_t faults;    // pros::motor_fault_e_t flags
+    bool connected;     // False if the port didn't answer, the other values are meaningless then
+};
+
+/// How long sampling the motors takes, to keep an eye on what it costs the other tasks.
+struct TelemetryStats {
+    uint32_t cycles;      // Times every motor was sampled
+    uint32_t lastMicros;  // Time the last cycle took, in microseconds
+    uint32_t worstMicros; // Longest cycle so far, in microseconds
+    double averageMicros; // Average cycle, in microseconds
+    uint32_t retries;     // Reads that had to start over because a new table was published during the copy
+};
+
+/**
+ * Samples every motor once per cycle in its own task, so the rest of the code reads a table instead of asking
+ * the smart ports for the same values again and again.
+ *
+ * The table is double buffered: the task fills the buffer nobody is reading, then flips to it. A read only has to
+ * start over if the task flipped while it was copying, at most once every TELEMETRY_PERIOD_MS.
+ */
+class MotorTelemetry {
+private:
+    pros::task_t telemetryTask;
+    bool taskRunning = false;
+
+    struct Table {
+        MotorSample motors[SMART_PORT_COUNT]; // Indexed by port - 1
+        uint64_t timestamp;                       // util::micros() when the cycle started
+    };
+    /// The task writes to buffers[(published + 1) % 2] and then increments published.
+    Table buffers[2] = {};
+    std::atomic<uint32_t> published{0};
+    std::atomic<uint32_t> retries{0};
+    util::SeqLock<TelemetryStats> stats;
+
+    static void telemetryTaskFn(void*);
+
+    /// Reads every motor into the buffer nobody is reading and publishes it.
+    void sample();
+
+public:
+    /// The V5 smart ports to sample
+    std::vector<int> ports;
+
+    /**
+     * \param portsUsed The V5 smart ports to sample, usually SELFCHECK_PORTS.
+     */
+    MotorTelemetry(std::vector<int> portsUsed);
+
+    /// Starts the telemetry task. Until it has run once, every motor reads as disconnected.
+    void startTask();
+
+    /// Ends the telemetry task. Reads keep returning the last table.
+    void endTask();
+
+    /**
+     * \param port The smart port, 1 to 21.
+     *
+     * \return What the motor on that port read in the last cycle.
+     */
+    MotorSample get(int port);
+
+    /// \return util::micros() when the last cycle started.
+    uint64_t getTimestamp();
+
+    /// \return How long sampling takes.
+    TelemetryStats getStats();
+};
+#endif /* _TELEMETRY_HPP_INCLUDED */
@@ -5,284 +5,684 @@
 #include <cstdlib>
 #include "systemmanager.hpp"
 #include "util/util.hpp"
+#include "util/pid.hpp"
+#include "util/math/mpc.hpp"
 #include "subsystem.hpp"
 #include "odometry.hpp"
 
-util::Pos2d targetPoint;
-double speed;
-double turningSpeed;
-double tolerance;
-bool isStopAtEnd;
-bool absLimit;
-double targetAngle;
-double angleTolerance;
-double strafeDistance;
-int timeout;
-
 bool AutoDrive::isSettled() {
-	return flag == IDLE;
+	return moves.isDone();
+}
+
+bool AutoDrive::waitUntilSettled(int timeout) {
+	return moves.wait(timeout);
+}
+
+util::Completion& AutoDrive::completion() {
+	return moves;
 }
 
 void AutoDrive::stop() {
-	if(flag) {
-		localStorage.log("deleted a task");
-		pros::c::task_delete(autoTask);
-		flag = IDLE;
+	if(isSettled())
+		return;
+
+	// Drops the moves that haven't started yet, then has the task stop the one running
+	Command command;
+	while(pros::c::queue_recv(commands, &command, 0))
+		moves.finish();
+	localStorage.log("Stopping automatic movement");
+	command.type = IDLE;
+	command.chained = command.passThrough = false;
+	send(command);
+}
+
+bool AutoDrive::send(const Command &command) {
+	if(autoTask == NULL) {
+		commands = pros::c::queue_create(AUTO_COMMAND_QUEUE_LENGTH, sizeof(Command));
+		pathMutex = pros::c::mutex_create();
+		autoTask = pros::c::task_create(autoTaskFn, this, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "AutoDrive Task");
 	}
+
+	// Counted before the move is queued so isSettled() is false from the moment this returns
+	moves.start();
+	flag = command.type;
+	if(!pros::c::queue_append(commands, &command, AUTO_COMMAND_TIMEOUT)) {
+		localStorage.log("AutoDrive command queue is full");
+		moves.finish();
+		return false;
+	}
+	return true;
 }
 
 AutoDrive::AutoDrive() {
 	resetSettings();
 }
 
-// The main logic for automatic moving, handles both driving to point and turn to angle
-void autoTaskFn(void *param) {
+// The main logic for automatic moving, handles driving to point, turning to angle and following a path.
+// Runs for the whole program, waiting for the next move whenever the robot is idle.
+void AutoDrive::autoTaskFn(void *param) {
 	AutoDrive *auton = (AutoDrive*) param;
 	double lastErrD = 0, lastErrA = 0, lastPower = 0;
 	double power, turn, strafe, errD, errA;
 
-	#pragma GCC diagnostic push
-	// dT is unused, but kept in case we end up using Δtime in auto for something
-	#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+	// dT moves the MPC's last solution along to the new horizon
 	uint32_t nowTime = pros::millis(), lastTime = nowTime, dT = 0;
-	#pragma GCC diagnostic pop
 	int stalling = 0, steadyState = 0;
-
-	// Creates the positional iterator pid controllers using pre-tuned values, specific to each robot.
-	auto powerController = okapi::IterativeControllerFactory::posPID(FORWARD_P, FORWARD_I, FORWARD_D);
-	auto strafeController = okapi::IterativeControllerFactory::posPID(STRAFE_P, STRAFE_I, STRAFE_D);
-	auto turningController = okapi::IterativeControllerFactory::posPID(TURNING_P, TURNING_I, TURNING_D);
-	// Sets the target of the PID controllers to 0.
-	// Error values will be fed in as current value. The PID controllers will try to minimize that.
-	powerController.setTarget(0);
-	turningController.setTarget(0);
-	strafeController.setTarget(0);
+	// True once the drive wheels started slipping against something during the move
+	bool contact = false;
+	WheelSlip slip;
+
+	// Creates the pid controllers using pre-tuned values, specific to each robot.
+	// They are only created once and carried over from one move to the next.
+	// The values were tuned with okapi's controllers, which only recomputed on every other 10ms loop
+	// (see tools/pidbench.cpp). These step every loop, so the integral is halved and the derivative doubled
+	// to drive the same way
+	util::Pid<> powerController(FORWARD_P, FORWARD_I / 2.0, FORWARD_D * 2.0);
+	util::Pid<> strafeController(STRAFE_P, STRAFE_I / 2.0, STRAFE_D * 2.0);
+	util::Pid<> turningController(TURNING_P, TURNING_I / 2.0, TURNING_D * 2.0);
 
 	// Creates the slewrate limiters, which limits the rate the speed of the robot changes, using pre-tuned values.
 	// This prevents things like tipping and jumping from sudden change in wheel speed.
-	util::SlewRateLimiter powerSlewRateLimiter(FORWARD_ACCEL, odometry.getChassisVel().y, FORWARD_DECEL);
-	util::SlewRateLimiter strafeSlewRateLimiter(STRAFE_ACCEL,odometry.getChassisVel().x,STRAFE_DECEL);
-	util::SlewRateLimiter turnSlewRateLimiter(TURNING_ACCEL, odometry.getChassisVel().angle, TURNING_DECEL);
-
+	util::SlewRateLimiter powerSlewRateLimiter(FORWARD_ACCEL, 0, FORWARD_DECEL);
+	util::SlewRateLimiter strafeSlewRateLimiter(STRAFE_ACCEL, 0, STRAFE_DECEL);
+	util::SlewRateLimiter turnSlewRateLimiter(TURNING_ACCEL, 0, TURNING_DECEL);
 
 	util::Pos2d closestPoint, closestPointSide;
 	double angleToClose, angleToTarget, distanceToClose, distanceToTarget, distanceToCloseSide, angleToCloseSide;
 	util::ChassisPos pos, sidewayPos;
-	
-	uint32_t startingTime = pros::millis();
+
+	// Pure pursuit values. Progress is how far along the path the robot is, in inches
+	double pathProgress, lookahead, pathSpeed;
+	bool pathEnd;
+	util::ChassisSpeed robotVel;
+	util::Path path;
+	util::Trajectory trajectory;
+	util::TrajectoryState trajectoryRef, trajectoryAhead;
+	// The acceleration the reference wants, relative to the robot like the drive outputs. Used by the feedforward
+	util::ChassisSpeed referenceAccel;
+
+	// Motion profile values. The robot follows the profile's reference along the line from where the move
+	// started to the target (or from the starting heading to the target heading)
+	bool profiled = false;
+	// True when following a trajectory, either given or planned to reach a pose
+	bool trackingTrajectory = false;
+	util::MotionProfile profile;
+	util::ProfileState reference;
+	util::ChassisPos profileStart;
+	util::Pos2d referencePoint;
+	double profileHeading = 0, profileTime = 0, profileDuration = 0, startVel, referenceAngle;
+	PoseSnapshot snapshot;
+	// The field velocity the last profiled move wanted, so a chained move continues from it instead of the noisier measurement
+	util::ChassisSpeed referenceVel = {0, 0, 0};
+	bool referenceValid = false;
+	Command next;
+	// Held from the first move until no moves are left, so other tasks can't move the drive in the meantime
+	ActuatorToken driveToken = 0;
+
+	// The move being run, and the settings it was started with
+	Command command;
+	util::Pos2d &targetPoint = command.point;
+	double &targetAngle = command.angle;
+	AutoSettings &settings = command.settings;
+	PathSettings &pathSettings = command.pathSettings;
+
+	// Model predictive control of profiled moves. Static so its matrices stay off the task's stack
+	static util::HolonomicMpc mpc(drive.getIKMatrix());
+	util::TrajectoryState horizon[util::HolonomicMpc::HORIZON + 1];
+	util::WheelSpeed mpcWheels;
+
+	// Where the profile or trajectory wants the robot to be at a time into the move, in the field frame
+	auto referenceAt = [&](double time) -> util::TrajectoryState {
+		if(trackingTrajectory)
+			return trajectory.sample(time);
+		util::ProfileState state = profile.sample(time);
+		if(command.type == TURNING)
+			return {{profileStart.x, profileStart.y, profileStart.angle + state.position}, {0, 0, state.velocity}};
+		// Faces the target or backs up to it, like the PID controllers do
+		return {{profileStart.x + state.position * sin(profileHeading), profileStart.y + state.position * cos(profileHeading),
+		         profileStart.angle + util::wrapAngle90(profileHeading - profileStart.angle)},
+		        {state.velocity * sin(profileHeading), state.velocity * cos(profileHeading), 0}};
+	};
+
+	// True while the robot is still moving from a move that didn't stop at its end
+	bool moving = false;
+	// True if the last move ended because a new one came in
+	bool preempted;
+
+	uint32_t startingTime;
 
 	// character buffer for printing things to the log
 	char logBuf[80];
-	if(auton->flag == AutoDrive::AutoFlag::DRIVING_TO_POINT)
-		sprintf(logBuf, "Starting Auton with target point %.2f %.2f", targetPoint.x, targetPoint.y);
-	else if(auton->flag == AutoDrive::AutoFlag::TURNING)
-		sprintf(logBuf, "Starting Auton with target angle %.2f", targetAngle);
-	localStorage.log(logBuf);
-
-	// "do..while loop" so we can run the logic first to fill up the variables.
-	// This way we don't have to write any additional initialization code.
-	do {
-		// Handles timeout
-		if(startingTime + timeout < pros::millis()){
-			sprintf(logBuf, "Auto timeout");
-			localStorage.log(logBuf);
-			break;
-		}
 
-		// "wakes" any settled controller as we are still in the loop and the robot is still moving
-		if(turningController.isSettled())
-			turningController.setTarget(0);
-		if(powerController.isSettled())
-			powerController.setTarget(0);
-		if(strafeController.isSettled())
-			strafeController.setTarget(0);
+	while(true) {
+		pros::c::queue_recv(auton->commands, &command, TIMEOUT_MAX);
+		auton->flag = command.type;
 
-		// Updates Time (technically unused)
-		nowTime = pros::millis();
-		dT = nowTime - lastTime;
-		lastTime = nowTime;
-
-		// Updates the current position of the robot
-		pos = odometry.getPos();
-
-		// The robot's position but sideways. Used to calculate strafing related values
-		sidewayPos = {pos.x, pos.y, util::wrapAngle(pos.angle + (M_PI/2.0))};
-
-		// Updates related points and values
-		closestPoint = pos.getClosestPointAsHeading(targetPoint);
-		closestPointSide = sidewayPos.getClosestPointAsHeading(targetPoint);
-		angleToClose = pos.getAngleToAsHeading(closestPoint);
-		angleToTarget = pos.getAngleToAsHeading(targetPoint);
-		angleToCloseSide = sidewayPos.getAngleToAsHeading(closestPointSide);
-		distanceToClose = pos.distance(closestPoint);
-		distanceToTarget = pos.distance(targetPoint);
-		distanceToCloseSide = sidewayPos.distance(closestPointSide);
-
-		// Prints debugging information to the V5 brain
-		pros::lcd::print(5, "Closest: %.2f %.2f", closestPoint.x, closestPoint.y);
-
-		// Flips the direction of error based on the robot's facing.
-		// Allows the robot to approach the target by backing up, if the target is behind the robot
-		if(abs(angleToClose) >= M_PI/2.0)
-			distanceToClose *= -1;
-		if(abs(angleToCloseSide) >= M_PI/2.0)
-			distanceToCloseSide *= -1;
-
-		if(abs(distanceToTarget) < strafeDistance) {
-			errA = 0;
-			errD = distanceToClose;
-		} else {
-			errA = angleToTarget;
-			errD = distanceToTarget;
-		}
-
-		// Stepping the PID controllers
-		// Steps differently based on if we are driving to point or turning to a heading
-		if(auton->flag == 2) {
-			errA = util::wrapAngle(targetAngle - pos.angle);
-			turningController.step(-errA);
-			powerController.step(0);
-			strafeController.step(0);
+		if(command.type == IDLE) {
+			drive.leftMoveRPM(0);
+			drive.rightMoveRPM(0);
+			moving = false;
+			referenceValid = false;
 		}
 		else {
-			errA = util::wrapAngle90(errA);
-			turningController.step(-errA);
-			powerController.step(-distanceToClose);
-			strafeController.step(-distanceToCloseSide);
-		}
+			if(driveToken == 0)
+				driveToken = arbiter.acquire(ACTUATOR_DRIVE, ARBITER_PRIORITY_ROUTINE, "AutoDrive");
+
+			if(command.type == FOLLOWING_PATH) {
+				pros::c::mutex_take(auton->pathMutex, TIMEOUT_MAX);
+				path = auton->path;
+				pros::c::mutex_give(auton->pathMutex);
+				pathProgress = 0;
+				lookahead = 0;
+				pathEnd = false;
+			}
+			else if(command.type == FOLLOWING_TRAJECTORY) {
+				pros::c::mutex_take(auton->pathMutex, TIMEOUT_MAX);
+				trajectory = auton->trajectory;
+				pros::c::mutex_give(auton->pathMutex);
+				targetPoint = {trajectory.end().x, trajectory.end().y};
+			}
+
+			// Starting from a stop, nothing should carry over from the last move.
+			// Otherwise, keeps the controllers and slew rates as they are so the speed doesn't jump between moves
+			if(!moving) {
+				powerController.reset();
+				strafeController.reset();
+				turningController.reset();
+				mpc.reset();
+				powerSlewRateLimiter.reset(odometry.getChassisVel().y);
+				strafeSlewRateLimiter.reset(odometry.getChassisVel().x);
+				turnSlewRateLimiter.reset(odometry.getChassisVel().angle);
+			}
+			// Sets the target of the PID controllers to 0.
+			// Error values will be fed in as current value. The PID controllers will try to minimize that.
+			powerController.setTarget(0);
+			turningController.setTarget(0);
+			strafeController.setTarget(0);
 
-		// Getting the PID controller outputs
-		power = powerController.getOutput() * speed;
-		turn = turningController.getOutput() * turningSpeed * speed;
-		strafe = strafeController.getOutput() * speed;
+			// Plans the straight line to the pose within the wheel limits, so the robot moves and turns at the same time
+			if(command.type == DRIVING_TO_POSE && settings.profile != util::MotionProfile::NONE) {
+				util::TrajectoryConstraints constraints;
+				constraints.maxWheelVelocity *= settings.speed;
+				trajectory = util::Trajectory::plan(odometry.getPos(), {{targetPoint.x, targetPoint.y, targetAngle}},
+				                                    drive.getIKMatrix(), constraints);
+			}
+
+			trackingTrajectory = command.type == FOLLOWING_TRAJECTORY ||
+			                     (command.type == DRIVING_TO_POSE && settings.profile != util::MotionProfile::NONE);
+			profiled = trackingTrajectory ||
+			           (settings.profile != util::MotionProfile::NONE && (command.type == DRIVING_TO_POINT || command.type == TURNING));
+			if(profiled) {
+				snapshot = odometry.getSnapshot();
+				profileStart = snapshot.pos;
+				if(referenceValid)
+					snapshot.fieldVel = referenceVel;
+				if(command.type == DRIVING_TO_POINT) {
+					// Heading of the straight line to the target. Forward is (sin, cos)
+					profileHeading = atan2(targetPoint.x - profileStart.x, targetPoint.y - profileStart.y);
+					startVel = moving ? snapshot.fieldVel.x * sin(profileHeading) + snapshot.fieldVel.y * cos(profileHeading) : 0;
+					profile = util::MotionProfile::generate(settings.profile, profileStart.distance(targetPoint),
+						{PROFILE_MAX_VEL_IN_S * settings.speed, PROFILE_MAX_ACCEL_IN_S2, PROFILE_MAX_JERK_IN_S3}, startVel,
+						command.passThrough ? command.endSpeed : 0);
+				}
+				else if(command.type == TURNING) {
+					startVel = moving ? snapshot.fieldVel.angle : 0;
+					profile = util::MotionProfile::generate(settings.profile, util::wrapAngle(targetAngle - profileStart.angle),
+						{PROFILE_MAX_TURN_RPS * settings.turningSpeed * settings.speed, PROFILE_MAX_TURN_ACCEL, PROFILE_MAX_TURN_JERK}, startVel);
+				}
+				profileDuration = trackingTrajectory ? trajectory.duration() : profile.duration();
+			}
+
+			lastErrD = lastErrA = lastPower = 0;
+			stalling = steadyState = 0;
+			contact = false;
+			preempted = false;
+			startingTime = pros::millis();
+
+			if(command.type == DRIVING_TO_POINT)
+				sprintf(logBuf, "Starting Auton with target point %.2f %.2f, %.2fs profile", targetPoint.x, targetPoint.y, profiled ? profile.duration() : 0);
+			else if(command.type == TURNING)
+				sprintf(logBuf, "Starting Auton with target angle %.2f", targetAngle);
+			else if(command.type == FOLLOWING_PATH)
+				sprintf(logBuf, "Starting Auton with a %.2f inch path", path.length());
+			else if(command.type == FOLLOWING_TRAJECTORY)
+				sprintf(logBuf, "Starting Auton with a %.2f inch, %.2fs trajectory", trajectory.length(), trajectory.duration());
+			else if(command.type == DRIVING_TO_POSE)
+				sprintf(logBuf, "Starting Auton with target pose %.2f %.2f %.2f", targetPoint.x, targetPoint.y, targetAngle);
+			localStorage.log(logBuf);
+
+			// "do..while loop" so we can run the logic first to fill up the variables.
+			// This way we don't have to write any additional initialization code.
+			do {
+				// A new move takes over right away, unless it's chained after this one
+				if(pros::c::queue_peek(auton->commands, &next, 0) && !next.chained) {
+					preempted = true;
+					break;
+				}
+
+				// Handles timeout
+				if(startingTime + settings.timeout < pros::millis()){
+					sprintf(logBuf, "Auto timeout");
+					localStorage.log(logBuf);
+					break;
+				}
+
+				// Updates Time
+				nowTime = pros::millis();
+				dT = nowTime - lastTime;
+				lastTime = nowTime;
+
+				// Updates the current position of the robot
+				pos = odometry.getPos();
+
+				// Where the profile wants the robot to be right now
+				if(profiled) {
+					profileTime = (pros::millis() - startingTime) / 1000.0;
+					if(profileTime > profileDuration + PROFILE_SETTLE_MS / 1000.0) {
+						sprintf(logBuf, "Auto profile didn't settle");
+						localStorage.log(logBuf);
+						break;
+					}
+					if(trackingTrajectory) {
+						trajectoryRef = trajectory.sample(profileTime);
+						referencePoint = {trajectoryRef.pos.x, trajectoryRef.pos.y};
+						referenceAngle = util::wrapAngle(trajectoryRef.pos.angle - pos.angle);
+						referenceVel = trajectoryRef.vel;
+					}
+					else {
+						reference = profile.sample(profileTime);
+						referencePoint = {profileStart.x + reference.position * sin(profileHeading),
+						                  profileStart.y + reference.position * cos(profileHeading)};
+						// The profile is in radians when turning and in inches otherwise, where the heading isn't profiled
+						if(command.type == TURNING) {
+							referenceAngle = util::wrapAngle(profileStart.angle + reference.position - pos.angle);
+							referenceVel = {0, 0, reference.velocity};
+						}
+						else {
+							referenceAngle = 0;
+							referenceVel = {reference.velocity * sin(profileHeading), reference.velocity * cos(profileHeading), 0};
+						}
+					}
+				}
+
+				// Pure pursuit: chases a point further along the path, until the end of the path is within the lookahead
+				if(command.type == FOLLOWING_PATH) {
+					robotVel = odometry.getSnapshot().robotVel;
+					pathProgress = path.closestArcLength({pos.x, pos.y}, pathProgress, pathSettings.maxLookahead);
+					lookahead = std::clamp(pathSettings.minLookahead + pathSettings.lookaheadGain * std::hypot(robotVel.x, robotVel.y),
+					                       pathSettings.minLookahead, pathSettings.maxLookahead);
+					// Shorter lookahead in tight curves so the robot doesn't cut the corner
+					lookahead = std::max(pathSettings.minLookahead, lookahead / (1 + lookahead * path.curvatureAt(pathProgress)));
+					pathEnd = path.length() - pathProgress <= lookahead;
+					targetPoint = pathEnd ? path.end() : path.pointAt(pathProgress + lookahead);
+				}
+
+				// The robot's position but sideways. Used to calculate strafing related values
+				sidewayPos = {pos.x, pos.y, util::wrapAngle(pos.angle + (M_PI/2.0))};
+
+				// Updates related points and values
+				closestPoint = pos.getClosestPointAsHeading(targetPoint);
+				closestPointSide = sidewayPos.getClosestPointAsHeading(targetPoint);
+				angleToClose = pos.getAngleToAsHeading(closestPoint);
+				angleToTarget = pos.getAngleToAsHeading(targetPoint);
+				angleToCloseSide = sidewayPos.getAngleToAsHeading(closestPointSide);
+				distanceToClose = pos.distance(closestPoint);
+				distanceToTarget = pos.distance(targetPoint);
+				distanceToCloseSide = sidewayPos.distance(closestPointSide);
+
+				// Prints debugging information to the V5 brain
+				pros::lcd::print(5, "Closest: %.2f %.2f", closestPoint.x, closestPoint.y);
+
+				// Flips the direction of error based on the robot's facing.
+				// Allows the robot to approach the target by backing up, if the target is behind the robot
+				if(abs(angleToClose) >= M_PI/2.0)
+					distanceToClose *= -1;
+				if(abs(angleToCloseSide) >= M_PI/2.0)
+					distanceToCloseSide *= -1;
+
+				if(abs(distanceToTarget) < settings.strafeDistance) {
+					errA = 0;
+					errD = distanceToClose;
+				} else {
+					errA = angleToTarget;
+					errD = distanceToTarget;
+				}
+
+				// Driving to a pose never gives up on the heading, and measures the distance to the target itself
+				if(command.type == DRIVING_TO_POSE) {
+					errA = util::wrapAngle(targetAngle - pos.angle);
+					errD = distanceToTarget;
+				}
+
+				// Stepping the PID controllers
+				// Steps differently based on if we are driving to point or turning to a heading
+				if(command.type == TURNING) {
+					errA = util::wrapAngle(targetAngle - pos.angle);
+					turningController.step(profiled ? -referenceAngle : -errA);
+					powerController.step(0);
+					strafeController.step(0);
+				}
+				else if(profiled) {
+					// Corrects the robot towards the reference point instead of the target.
+					// Trajectories plan the heading too, otherwise the robot faces the target like without a profile
+					errA = trackingTrajectory ? referenceAngle : util::wrapAngle90(errA);
+					turningController.step(-errA);
+					powerController.step(-pos.distance(referencePoint) * cos(pos.getAngleToAsHeading(referencePoint)));
+					strafeController.step(-pos.distance(referencePoint) * sin(pos.getAngleToAsHeading(referencePoint)));
+				}
+				else if(command.type == DRIVING_TO_POSE) {
+					// All three axes at once, with the error to the target split into the robot's forward and sideways
+					turningController.step(-errA);
+					powerController.step(-distanceToTarget * cos(angleToTarget));
+					strafeController.step(-distanceToTarget * sin(angleToTarget));
+				}
+				else {
+					errA = util::wrapAngle90(errA);
+					turningController.step(-errA);
+					powerController.step(-distanceToClose);
+					strafeController.step(-distanceToCloseSide);
+				}
+
+				// Getting the PID controller outputs
+				power = powerController.getOutput() * settings.speed;
+				turn = turningController.getOutput() * settings.turningSpeed * settings.speed;
+				strafe = strafeController.getOutput() * settings.speed;
+
+				// Until the end of the path is in reach, drives straight at the lookahead point instead of settling on it.
+				// Slows down so the curve ahead can be taken without sliding out
+				if(command.type == FOLLOWING_PATH && !pathEnd) {
+					pathSpeed = std::sqrt(pathSettings.maxLateralAccel / std::max(path.curvatureAt(pathProgress + lookahead), 1e-6));
+					pathSpeed = settings.speed * std::min(1.0, pathSpeed / (MAX_SPEED_IN_S * M_SQRT2));
+					power = pathSpeed * cos(angleToTarget);
+					strafe = pathSpeed * sin(angleToTarget);
+					errD = path.length() - pathProgress;
+				}
 		
-		// Limits the rate of change for the three values
-		power = powerSlewRateLimiter.calculate(power);
-		turn = turnSlewRateLimiter.calculate(turn);
-		strafe = strafeSlewRateLimiter.calculate(strafe);
+				referenceAccel = {0, 0, 0};
+				if(profiled) {
+					// The profile's velocity does most of the driving, and the PID controllers correct the error from it
+					if(command.type == TURNING) {
+						turn += reference.velocity / MAX_CHASSIS_RPS;
+						referenceAccel.angle = reference.acceleration;
+					}
+					else if(trackingTrajectory) {
+						// Field velocity turned into the robot's frame
+						power += (trajectoryRef.vel.x * sin(pos.angle) + trajectoryRef.vel.y * cos(pos.angle)) / (MAX_SPEED_IN_S * M_SQRT2);
+						strafe += (trajectoryRef.vel.x * cos(pos.angle) - trajectoryRef.vel.y * sin(pos.angle)) / (MAX_SPEED_IN_S * M_SQRT2);
+						turn += trajectoryRef.vel.angle / MAX_CHASSIS_RPS;
+						// Trajectories only plan velocities, so the acceleration is the change over the next loop
+						trajectoryAhead = trajectory.sample(profileTime + 0.01);
+						referenceAccel = {((trajectoryAhead.vel.x - trajectoryRef.vel.x) * cos(pos.angle) - (trajectoryAhead.vel.y - trajectoryRef.vel.y) * sin(pos.angle)) / 0.01,
+						                  ((trajectoryAhead.vel.x - trajectoryRef.vel.x) * sin(pos.angle) + (trajectoryAhead.vel.y - trajectoryRef.vel.y) * cos(pos.angle)) / 0.01,
+						                  (trajectoryAhead.vel.angle - trajectoryRef.vel.angle) / 0.01};
+					}
+					else {
+						power += reference.velocity * cos(util::wrapAngle(profileHeading - pos.angle)) / (MAX_SPEED_IN_S * M_SQRT2);
+						strafe += reference.velocity * sin(util::wrapAngle(profileHeading - pos.angle)) / (MAX_SPEED_IN_S * M_SQRT2);
+						referenceAccel = {reference.acceleration * sin(util::wrapAngle(profileHeading - pos.angle)),
+						                  reference.acceleration * cos(util::wrapAngle(profileHeading - pos.angle)), 0};
+					}
+
+					// The profile already limits the acceleration. Keeps the slew rate limiters in step for the next move
+					powerSlewRateLimiter.reset(power);
+					turnSlewRateLimiter.reset(turn);
+					strafeSlewRateLimiter.reset(strafe);
+				}
+				else {
+					// Limits the rate of change for the three values
+					power = powerSlewRateLimiter.calculate(power);
+					turn = turnSlewRateLimiter.calculate(turn);
+					strafe = strafeSlewRateLimiter.calculate(strafe);
+				}
 		
-		// Detecting stalling
-		if (drive.getStalling()) {
-			stalling++;
-			sprintf(logBuf, "Drive Stalling: %d", stalling);
-			if(stalling%5 == 0)
-				localStorage.log(logBuf);
-		}
-		else {
-			if (stalling > 0)
-				stalling -= 5;
-			if(stalling < 0)
-				stalling = 0;
-		}
-		// Detecting steadystate
-		if (abs(errD - lastErrD) < (0.1 / 100.0) && abs(errA - lastErrA) < (d2r(10) / 100.0) && abs(power - lastPower) < (0.1 / 100.0)) {
-			steadyState++;
-			sprintf(logBuf, "Auto Steady State: %d", steadyState);
-			if(steadyState%5 == 0)
-				localStorage.log(logBuf);
-		}
-		else {
-			if (steadyState > 0)
-				steadyState -= 5;
-			if(steadyState < 0)
-					steadyState = 0;
+				// Detecting contact. The wheels spin against the tracking wheels as soon as the robot pushes into something,
+				// long before the motors stall or the steady state count runs up
+				if (settings.onContact != AutoSettings::CONTACT_IGNORE && !contact && pros::millis() - startingTime > AUTO_CONTACT_GRACE_MS) {
+					slip = odometry.getSlip();
+					if (slip.contact) {
+						contact = true;
+						sprintf(logBuf, "Auto contact, slip %.2f %.2f %.2f %.2f", slip.ratio.lf, slip.ratio.lr, slip.ratio.rf, slip.ratio.rr);
+						localStorage.log(logBuf);
+						if (settings.onContact == AutoSettings::CONTACT_END)
+							break;
+					}
+				}
+
+				// Detecting stalling
+				if (drive.getStalling()) {
+					stalling++;
+					sprintf(logBuf, "Drive Stalling: %d", stalling);
+					if(stalling%5 == 0)
+						localStorage.log(logBuf);
+				}
+				else {
+					if (stalling > 0)
+						stalling -= 5;
+					if(stalling < 0)
+						stalling = 0;
+				}
+				// Detecting steadystate. The robot barely moves at the start of a profile, so only once it's over
+				if ((!profiled || profileTime > profileDuration) && abs(errD - lastErrD) < (0.1 / 100.0) && abs(errA - lastErrA) < (d2r(10) / 100.0) && abs(power - lastPower) < (0.1 / 100.0)) {
+					steadyState++;
+					sprintf(logBuf, "Auto Steady State: %d", steadyState);
+					if(steadyState%5 == 0)
+						localStorage.log(logBuf);
+				}
+				else {
+					if (steadyState > 0)
+						steadyState -= 5;
+					if(steadyState < 0)
+							steadyState = 0;
+				}
+
+				// Breaking if the robot is stuck or not moving
+				if (stalling+steadyState > 15) {
+					sprintf(logBuf, "Breaking due to steady or stalling");
+					localStorage.log(logBuf);
+					break;
+				}
+
+				// Keeps pushing gently instead of spinning the wheels at full speed
+				if(contact)
+					settings.absLimit = std::min(settings.absLimit, AUTO_CONTACT_POWER);
+
+				// applies the calculated velocity values to the drive base.
+				// The feedforward model turns them into voltages, so the PID controllers only have to correct what it misses.
+				// With model predictive control, the wheel speeds come from the controller instead
+				if(profiled && settings.mpc) {
+					for(int k = 0; k <= util::HolonomicMpc::HORIZON; k++)
+						horizon[k] = referenceAt(profileTime + k * MPC_STEP_S);
+					uint64_t solveStart = util::micros();
+					mpcWheels = mpc.solve(pos, horizon, MAX_SPEED_IN_S * std::clamp(settings.absLimit, 0.0, 1.0), dT / 1000.0);
+					uint64_t solveTime = util::micros() - solveStart;
+					// A solve over its budget leaves too little of the cycle for the rest of the loop.
+					// Still uses this one, the PID controllers take over from the next
+					if(solveTime > MPC_MAX_SOLVE_US) {
+						settings.mpc = false;
+						sprintf(logBuf, "MPC solve took %lluus, using PID for the rest of the move", (unsigned long long)solveTime);
+						localStorage.log(logBuf);
+					}
+					if(AUTO_FEEDFORWARD)
+						drive.setWheelSpeedFF(mpcWheels, mpc.getAcceleration());
+					else
+						drive.setWheelSpeed(mpcWheels, 200.0 / MAX_SPEED_IN_S);
+				}
+				else if(AUTO_FEEDFORWARD)
+					drive.setChassisSpeedFF({strafe * MAX_SPEED_IN_S * M_SQRT2, power * MAX_SPEED_IN_S * M_SQRT2, turn * MAX_CHASSIS_RPS}, referenceAccel, settings.absLimit);
+				else
+					drive.setChassisSpeedIK({strafe * MAX_SPEED_IN_S * M_SQRT2, power * MAX_SPEED_IN_S * M_SQRT2, turn * MAX_CHASSIS_RPS}, settings.absLimit);
+
+				// Updates "last" values used to calculate changes
+				lastErrA = errA;
+				lastErrD = errD;
+				if(robotConfigs.debugging)
+					pros::lcd::print(AUTO_LCD_LINE, "power:%.1f, turn:%.1f, strafe:%.1f", power, turn, strafe);
+
+				pros::delay(10);
+		
+				// Runs the loop until all controllers have settled and we have reached the target.
+				// Profiled moves finish as soon as the profile is over and the robot is within tolerance.
+				// Moves passing through a point finish as soon as the robot is close enough
+			} while(command.passThrough ? errD > settings.tolerance : profiled ? (
+				profileTime < profileDuration ||
+				(command.type != TURNING && errD > settings.tolerance) ||
+				(command.type != DRIVING_TO_POINT && abs(errA) > settings.angleTolerance)) : (
+				(!powerController.isSettled()) || 
+				(!strafeController.isSettled()) || 
+				(!turningController.isSettled()) || 
+				(command.type == DRIVING_TO_POINT && errD > settings.tolerance) || 
+				(command.type == TURNING && abs(errA) > settings.angleTolerance) ||
+				(command.type == FOLLOWING_PATH && (!pathEnd || errD > settings.tolerance)) ||
+				(command.type == DRIVING_TO_POSE && (errD > settings.tolerance || abs(errA) > settings.angleTolerance))));
+
+			// Runs on after a preempted move or with isStopAtEnd off, so the next move picks up the robot's speed
+			moving = preempted || !settings.isStopAtEnd;
+			referenceValid = moving && profiled;
+			if (!moving) {
+				drive.leftMoveRPM(0);
+				drive.rightMoveRPM(0);
+			}
 		}
 
-		// Breaking if the robot is stuck or not moving
-		if (stalling+steadyState > 15) {
-			sprintf(logBuf, "Breaking due to steady or stalling");
-			localStorage.log(logBuf);
-			break;
+		// Done with this move. Lets whoever is waiting know once no more moves are left
+		if(auton->moves.remaining() == 1) {
+			auton->flag = IDLE;
+			arbiter.release(driveToken);
+			driveToken = 0;
 		}
+		auton->moves.finish();
+	}
+}
 
-		// applies the calculated velocity values to the drive base
-		drive.setChassisSpeedIK({strafe * MAX_SPEED_IN_S * M_SQRT2, power * MAX_SPEED_IN_S * M_SQRT2, turn * MAX_CHASSIS_RPS}, absLimit);
+bool AutoDrive::driveToPointAsync(const util::Pos2d input) {
+	Command command;
+	command.type = DRIVING_TO_POINT;
+	command.chained = command.passThrough = false;
+	command.point = input;
+	command.settings = settings;
+	return send(command); // This function is async, true only means the move was queued (does not incicate status of autotask).
+}
 
-		// Updates "last" values used to calculate changes
-		lastErrA = errA;
-		lastErrD = errD;
-		if(robotConfigs.debugging)
-			pros::lcd::print(AUTO_LCD_LINE, "power:%.1f, turn:%.1f, strafe:%.1f", power, turn, strafe);
+bool AutoDrive::turnToAngleAsync(double input) {
+	Command command;
+	command.type = TURNING;
+	command.chained = command.passThrough = false;
+	command.angle = input;
+	command.settings = settings;
+	return send(command); // This function is async, true only means the move was queued (does not incicate status of autotask).
+}
 
-		pros::delay(10);
-		
-		// Runs the loop until all controllers have settled and we have reached the target
-	} while(
-		(!powerController.isSettled()) || 
-		(!strafeController.isSettled()) || 
-		(!turningController.isSettled()) || 
-		(auton->flag == 1 && errD > tolerance) || 
-		(auton->flag == 2 && abs(errA) > angleTolerance));
-
-	if (isStopAtEnd) {
-		drive.leftMoveRPM(0);
-		drive.rightMoveRPM(0);
+bool AutoDrive::driveToPoseAsync(const util::ChassisPos input) {
+	Command command;
+	command.type = DRIVING_TO_POSE;
+	command.chained = command.passThrough = false;
+	command.point = {input.x, input.y};
+	command.angle = input.angle;
+	command.settings = settings;
+	return send(command); // This function is async, true only means the move was queued (does not incicate status of autotask).
+}
+
+bool AutoDrive::driveThroughAsync(const std::vector<ChainTarget> &targets) {
+	bool queued = true;
+	for(size_t i = 0; i < targets.size(); i++) {
+		Command command;
+		command.type = DRIVING_TO_POINT;
+		command.point = targets[i].point;
+		command.settings = settings;
+		// The first move takes over from whatever is running, the rest wait their turn
+		command.chained = i > 0;
+		command.passThrough = !targets[i].stop && i + 1 < targets.size();
+		command.endSpeed = 0;
+		if(command.passThrough) {
+			command.settings.tolerance = targets[i].passTolerance;
+			command.settings.isStopAtEnd = false;
+
+			// Passes through at full speed when the next point is straight ahead, slowing down for sharper corners.
+			// Stops completely if the robot has to turn back the way it came
+			util::Pos2d last = i > 0 ? targets[i - 1].point : util::Pos2d(odometry.getPos().x, odometry.getPos().y);
+			util::Pos2d point = targets[i].point, next = targets[i + 1].point;
+			util::Pos2d in = point - last, out = next - point;
+			double cosCorner = in.norm() * out.norm() > 0 ? (in.x * out.x + in.y * out.y) / (in.norm() * out.norm()) : 0;
+			command.endSpeed = PROFILE_MAX_VEL_IN_S * settings.speed * std::max(0.0, cosCorner + 1) / 2.0;
+		}
+		queued = send(command) && queued;
 	}
-	auton->flag = AutoDrive::AutoFlag::IDLE;
+	return queued; // This function is async, true only means the moves were queued (does not incicate status of autotask).
 }
 
-bool AutoDrive::driveToPointAsync(const util::Pos2d input) {
-	// Stops any current automatic movements, if any. 
-	stop();
-	pros::delay(20);
-	targetPoint = input;
-	flag = AutoFlag::DRIVING_TO_POINT;
-	autoTask = pros::c::task_create(autoTaskFn, this, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "AutoDrive Task");
-
-	return true; // This function is async and will always succeed (does not incicate status of autotask).
+bool AutoDrive::followPathAsync(const util::Path &input, PathSettings pathSettings) {
+	Command command;
+	command.type = FOLLOWING_PATH;
+	command.chained = command.passThrough = false;
+	command.settings = settings;
+	command.pathSettings = pathSettings;
+	if(pathMutex != NULL)
+		pros::c::mutex_take(pathMutex, TIMEOUT_MAX);
+	path = input;
+	if(pathMutex != NULL)
+		pros::c::mutex_give(pathMutex);
+	return send(command); // This function is async, true only means the move was queued (does not incicate status of autotask).
 }
 
-bool AutoDrive::turnToAngleAsync(double input) {
-	// Stops any current automatic movements, if any. 
-	stop();
-	pros::delay(20);
-	targetAngle = input;
-	flag = AutoFlag::TURNING;
-	autoTask = pros::c::task_create(autoTaskFn, this, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "AutoDrive Task");
-	return true; // This function is async and will always succeed (does not incicate status of autotask).
+bool AutoDrive::followTrajectoryAsync(const util::Trajectory &input) {
+	Command command;
+	command.type = FOLLOWING_TRAJECTORY;
+	command.chained = command.passThrough = false;
+	command.settings = settings;
+	if(pathMutex != NULL)
+		pros::c::mutex_take(pathMutex, TIMEOUT_MAX);
+	trajectory = input;
+	if(pathMutex != NULL)
+		pros::c::mutex_give(pathMutex);
+	return send(command); // This function is async, true only means the move was queued (does not incicate status of autotask).
 }
 
 // --------- Functions for setting drive settings --------- //
 AutoDrive& AutoDrive::withTolerance(const double input) {
-	tolerance = input;
+	settings.tolerance = input;
 	return *this;
 }
 AutoDrive& AutoDrive::withSpeed(double input) {
-	speed = input;
+	settings.speed = input;
 	return *this;
 }
 AutoDrive& AutoDrive::withTurnSpeed(double input) {
-	turningSpeed = input;
+	settings.turningSpeed = input;
 	return *this;
 }
 AutoDrive& AutoDrive::stopAtEnd(bool input) {
-	isStopAtEnd = input;
+	settings.isStopAtEnd = input;
 	return *this;
 }
 AutoDrive& AutoDrive::withMaxMotorSpeed(double speed) {
-	absLimit = speed;
+	settings.absLimit = speed;
 	return *this;
 }
 AutoDrive& AutoDrive::withAngleTolerance(double input) {
-	angleTolerance = input;
+	settings.angleTolerance = input;
 	return *this;
 }
 AutoDrive& AutoDrive::withStrafeDistance(double input) {
-	strafeDistance = input;
+	settings.strafeDistance = input;
 	return *this;
 }
 AutoDrive& AutoDrive::withTimeout(int input) {
-	timeout = input;
+	settings.timeout = input;
 	return *this;
 }
-AutoDrive& AutoDrive::resetSettings() {
-	speed = speedDefault;
-	turningSpeed = turningSpeedDefault;
-	tolerance = toleranceDefault;
-	isStopAtEnd = isStopAtEndDefault;
-	absLimit = absLimitDefault;
-	angleTolerance = angleToleranceDefault;
-	strafeDistance = strafeDistanceDefault;
-	timeout = timeoutDefault;
+AutoDrive& AutoDrive::withProfile(util::MotionProfile::Type input) {
+	settings.profile = input;
 	return *this;
 }
+AutoDrive& AutoDrive::withMpc(bool input) {
+	settings.mpc = input;
+	return *this;
+}
+AutoDrive& AutoDrive::withContactAction(AutoSettings::ContactAction input) {
+	settings.onContact = input;
+	return *this;
+}
+AutoDrive& AutoDrive::resetSettings() {
+	settings = AutoSettings();
+	return *this;
+}
\ No newline at end of file
@@ -2,54 +2,183 @@
 #define _AUTO_HPP_INCLUDED
 
 #include "api.h"
+#include "pros/apix.h"
 #include "okapi/api.hpp"
+#include "profiles.hpp"
 
 #include "util/struct.hpp"
+#include "util/util.hpp"
+#include "util/completion.hpp"
+#include "util/path.hpp"
+#include "util/math/motionprofile.hpp"
+#include "util/math/trajectory.hpp"
 
-// void follow_path(std::vector<Pos2d> &inPathToFollow, double inOverallSpeed, double inPowerfactor, double inTurningfactor, double indTolerance, double inaTolerance, double inaccelmilli, double inMaxLookAhead, double inMinLookAhead, double inlookAheadIncreaseDistance, bool inStopAtEnd);
+/// Tuning for AutoDrive::followPathAsync. Everything else (speed, tolerance, timeout...) comes from the usual settings.
+struct PathSettings {
+    double minLookahead = PATH_MIN_LOOKAHEAD_IN; // Shortest lookahead distance in inches
+    double maxLookahead = PATH_MAX_LOOKAHEAD_IN; // Longest lookahead distance in inches
+    double lookaheadGain = PATH_LOOKAHEAD_GAIN; // Inches of lookahead added per inch per second of speed
+    double maxLateralAccel = PATH_MAX_LATERAL_ACCEL; // Limits the speed through curves, in inches per second squared
+};
+
+/// Settings for automatic movements. Each move keeps the settings it was started with.
+struct AutoSettings {
+    double speed = 1; //The maximum speed in percentage
+    double turningSpeed = 1; //The maximum turn speed in percentage
+    double tolerance = 1.5; //The distance tolerance in inches
+    bool isStopAtEnd = true; //Wether or not the robot should stop after an automatic movement
+    double absLimit = 1; //The maximum percentage speed for a motor to spin at
+    double angleTolerance = d2r(3.5); //The heading tolerance in radians
+
+    //The distance when the robot gives up on turning
+    //This value helps in preventing the robot from spinning in circles from missing its target slightly
+    double strafeDistance = 3;
+
+    int timeout = 5000; //The timeout in milliseconds
+
+    //The motion profile driving to a point and turning follow. Path following isn't profiled
+    util::MotionProfile::Type profile = AUTO_PROFILE;
+
+    //Tracks profiles and trajectories with the model predictive controller instead of the PID controllers
+    bool mpc = AUTO_MPC;
+
+    /// What a move does once the drive wheels slip because the robot is pushing into something (see SlipDetector)
+    enum ContactAction {
+        CONTACT_IGNORE,   // Keeps going until it reaches the target, stalls, settles or times out
+        CONTACT_END,      // Ends the move right away, like it reached the target
+        CONTACT_CUT_POWER // Keeps pushing at AUTO_CONTACT_POWER until the move ends some other way
+    };
+    ContactAction onContact = CONTACT_IGNORE;
+};
+
+/// One point of a chain of moves for AutoDrive::driveThroughAsync.
+struct ChainTarget {
+    util::Pos2d point; // Inches
+    double passTolerance = CHAIN_PASS_TOLERANCE_IN; // How close the robot has to get before heading to the next point
+    bool stop = false; // Slows down to a stop here and settles within the usual tolerance, like the last point
+};
 
 class AutoDrive {
 private:
-    pros::task_t autoTask; //The task handling the automatic driving logic
-    const double speedDefault = 1; //The default speed
-    const double turningSpeedDefault = 1;//The default turn speed
-    const double toleranceDefault = 1.5;//The default tolerance
-    const bool isStopAtEndDefault = true;//The default setting for wether or not the robot should stop after an automatic movement
-    const bool absLimitDefault = 1; //The default maximum percentage speed for a motor to spin at
-    const double angleToleranceDefault = d2r(3.5); //The default heading tolerance in radians
-
-    //The default distance when the robot gives up on turning
-    //This value helps in preventing the robot from spinning in circles from missing its target slightly
-    const double strafeDistanceDefault = 3;
+    pros::task_t autoTask = NULL; //The task handling the automatic driving logic. Started with the first move and kept running
+    /// Moves for the AutoDrive task. A new move takes over from the one running, without stopping the robot in between.
+    pros::c::queue_t commands = NULL;
+    /// The path and trajectory for the latest followPathAsync and followTrajectoryAsync calls.
+    /// Copied by the AutoDrive task when the move starts
+    util::Path path;
+    util::Trajectory trajectory;
+    pros::mutex_t pathMutex = NULL;
+    /// Counts the moves that were started and haven't finished yet, including stops.
+    /// Wakes up the tasks in waitUntilSettled when the last one finishes.
+    util::Completion moves;
+    AutoSettings settings;
 
-    const int timeoutDefault = 5000; //The default timeout in milliseconds
+    static void autoTaskFn(void*);
 
 public:
     AutoDrive();
     
     /**
      * Have the robot drive to a point on the field automatically.
+     * A new move takes over from the one running right away, without stopping the robot first.
      * \param target The coordinate of the target point.
-     * \return Returns true as the rob
+     * \return True if the move was queued for the AutoDrive task.
      */
     bool driveToPointAsync(const util::Pos2d input);
     bool turnToAngleAsync(double targetAngle);
 
+    /**
+     * Have the robot drive to a point and turn to a heading at the same time, instead of driving then turning.
+     * Drives all three axes towards the target in the field frame. With a motion profile set, it follows a trajectory
+     * planned within the wheel limits (see util::Trajectory), so the translation and turn share the wheels' capacity.
+     * Finishes once both the distance and heading tolerances are met.
+     *
+     * \param target The target position, angle in radians.
+     *
+     * \return True if the move was queued for the AutoDrive task.
+     */
+    bool driveToPoseAsync(const util::ChassisPos target);
+
+    /**
+     * Have the robot drive through several points without stopping at each one.
+     * The robot only has to pass within each point's pass tolerance, and carries its speed into the next move.
+     * With a motion profile set, it passes through each point as fast as the corner to the next one allows,
+     * and only slows down to a stop at the last point and at points marked as stops.
+     *
+     * \param targets The points in order. At most AUTO_COMMAND_QUEUE_LENGTH of them.
+     *
+     * \return True if every move was queued for the AutoDrive task.
+     */
+    bool driveThroughAsync(const std::vector<ChainTarget> &targets);
+
+    /**
+     * Have the robot follow a path through several waypoints in one continuous motion, using pure pursuit.
+     * The robot drives towards a point a lookahead distance further along the path, and faces where it's going.
+     * The lookahead grows with speed and shrinks in tight curves. Once the end of the path is within the lookahead,
+     * it finishes the same way driveToPointAsync does.
+     *
+     * \param path The path to follow.
+     *
+     * \param settings Lookahead and curve speed tuning.
+     *
+     * \return True if the move was queued for the AutoDrive task.
+     */
+    bool followPathAsync(const util::Path &path, PathSettings settings = PathSettings());
+
+    /**
+     * Have the robot follow a trajectory, moving and turning at the same time.
+     * The trajectory's velocity drives the robot and the PID controllers correct the error from where it should be.
+     * Finishes once the trajectory is over and the robot is within the distance and heading tolerances of its end.
+     *
+     * \param trajectory The trajectory to follow, planned from where the robot is (see util::Trajectory::plan).
+     *
+     * \return True if the move was queued for the AutoDrive task.
+     */
+    bool followTrajectoryAsync(const util::Trajectory &trajectory);
     /**
      * The Flag is used internally to determine what the robot is doing.
      * 0 = not moving automatically
      * 1 = moving to a point automatically
      * 2 = turning to an angle automatically
+     * 3 = following a path automatically
+     * 4 = following a trajectory automatically
+     * 5 = driving to a position and heading at the same time automatically
      */
     enum AutoFlag {
         IDLE = 0,
         DRIVING_TO_POINT = 1,
-        TURNING = 2
+        TURNING = 2,
+        FOLLOWING_PATH = 3,
+        FOLLOWING_TRAJECTORY = 4,
+        DRIVING_TO_POSE = 5
     };
 
+    /// What the AutoDrive task is currently doing. Use isSettled() to check if the robot is done moving.
     AutoFlag flag = IDLE;
+
+private:
+    /// One move for the AutoDrive task.
+    struct Command {
+        AutoFlag type; // IDLE stops the robot
+        util::Pos2d point; // DRIVING_TO_POINT and DRIVING_TO_POSE: the target point
+        double angle; // TURNING and DRIVING_TO_POSE: the target heading in radians
+        AutoSettings settings;
+        PathSettings pathSettings; // FOLLOWING_PATH: the path itself is in path
+        bool chained; // Waits for the move before it to finish instead of taking over from it
+        bool passThrough; // DRIVING_TO_POINT: finishes once within settings.tolerance, without settling
+        double endSpeed; // DRIVING_TO_POINT: speed to pass through the point at when profiled, in inches per second
+    };
+
+    /**
+     * Hands a move to the AutoDrive task, starting the task if it isn't running yet.
+     * 
+     * \return False if the move couldn't be queued.
+     */
+    bool send(const Command &command);
+
+public:
     
-    /// Stops any automatic movements, if any.
+    /// Stops any automatic movements, if any. Moves that haven't started yet are dropped.
     void stop();
     /// Sets the tolerance in distance in inches. Returns a refrence to this object so you can chain functions.
     AutoDrive& withTolerance(const double input);
@@ -67,14 +196,33 @@ class AutoDrive {
     AutoDrive& withStrafeDistance(double input);
     ///  Sets the timeout for an automatic movement. Returns a refrence to this object so you can chain functions.
     AutoDrive& withTimeout(int input);
+    /// Sets the motion profile for driving to a point and turning. Returns a refrence to this object so you can chain functions.
+    AutoDrive& withProfile(util::MotionProfile::Type input);
+    /// Sets whether profiled moves are tracked with model predictive control. Returns a refrence to this object so you can chain functions.
+    AutoDrive& withMpc(bool input);
+
+    /// Sets what a move does when the robot pushes into something. Returns a refrence to this object so you can chain functions.
+    AutoDrive& withContactAction(AutoSettings::ContactAction input);
     /// Resets all configs to default. Returns a refrence to this object so you can chain functions.
     AutoDrive& resetSettings();
     /**
      * Checks if the automatic movement has finished.
      * 
-     * \return True if flag is 0, which generally means that the automatic movement have finished,
-     * false otherwise.
+     * \return True if no moves are running or waiting to run, false otherwise.
      */
     bool isSettled();
+
+    /**
+     * Blocks until the automatic movement has finished. Woken up by the AutoDrive task as soon as the last move ends,
+     * instead of polling isSettled().
+     *
+     * \param timeout The maximum time to wait in milliseconds, or NO_TIME_OUT to wait as long as it takes.
+     *
+     * \return True if the movement finished, false if it timed out.
+     */
+    bool waitUntilSettled(int timeout = NO_TIME_OUT);
+
+    /// \return The Completion finished when the last move ends, for util::runAsBlocking.
+    util::Completion& completion();
 };
 #endif /* _AUTO_HPP_INCLUDED */
@@ -0,0 +1,150 @@
+#include "calibration.hpp"
+
+#include <cmath>
+#include "Eigen/QR"
+#include "profiles.hpp"
+#include "io.hpp"
+#include "systemmanager.hpp"
+#include "util/util.hpp"
+
+namespace calibration {
+    Result solve(const std::vector<Sample> &samples) {
+        Result result = {false, ENC_BASE_WIDTH_IN, BACK_TO_CENTER_IN, 1, 0, 0};
+
+        // Compare over a few samples at a time, single readings are mostly quantization noise and IMU lag
+        std::vector<Sample> windows;
+        for (size_t i = 0; i < samples.size(); i += CALIBRATION_WINDOW)
+            windows.push_back(samples[i]);
+        if (windows.size() < 3)
+            return result;
+        size_t rows = windows.size() - 1;
+
+        // Left and right: dL * left - dR * left * rightWheelScale = trackingWidth * dA
+        // Turning gives the ratio of the two, driving straight separates them
+        Eigen::MatrixXd sides(rows, 2);
+        Eigen::VectorXd leftMoved(rows);
+        // Back: dB * back = -backToCenter * dA, but only when not strafing
+        Eigen::VectorXd turned(rows), backMoved(rows);
+        int backRows = 0;
+        double totalTurn = 0;
+        for (size_t i = 0; i < rows; i++) {
+            const Sample &a = windows[i], &b = windows[i + 1];
+            double dA = b.heading - a.heading;
+            double dR = (b.right - a.right) * SIDE_ENC_TO_IN;
+            sides(i, 0) = dA;
+            sides(i, 1) = dR;
+            leftMoved(i) = (b.left - a.left) * SIDE_ENC_TO_IN;
+            if (!a.strafing && !b.strafing) {
+                turned(backRows) = -dA;
+                backMoved(backRows) = (b.back - a.back) * BACK_ENC_TO_IN;
+                backRows++;
+            }
+            totalTurn += std::fabs(dA);
+        }
+        // Without enough turning the width isn't observable at all
+        if (totalTurn < 4 * M_PI || backRows < 2)
+            return result;
+
+        Eigen::Vector2d sideFit = sides.colPivHouseholderQr().solve(leftMoved);
+        Eigen::VectorXd backFit = turned.head(backRows).colPivHouseholderQr().solve(backMoved.head(backRows));
+
+        result.trackingWidth = sideFit(0);
+        result.rightWheelScale = sideFit(1);
+        result.backToCenter = backFit(0);
+        result.widthResidual = std::sqrt((sides * sideFit - leftMoved).squaredNorm() / rows);
+        result.backResidual = std::sqrt((turned.head(backRows) * backFit - backMoved.head(backRows)).squaredNorm() / backRows);
+
+        // Anything too far from what was measured by hand means something slipped or a sensor is unplugged
+        result.valid = std::fabs(result.trackingWidth - ENC_BASE_WIDTH_IN) < CALIBRATION_MAX_WIDTH_CHANGE_IN &&
+                       std::fabs(result.backToCenter - BACK_TO_CENTER_IN) < CALIBRATION_MAX_WIDTH_CHANGE_IN &&
+                       std::fabs(result.rightWheelScale - 1) < CALIBRATION_MAX_SCALE_CHANGE;
+        return result;
+    }
+
+    namespace {
+        /// One step of the scripted routine. Speeds are fractions of full speed, like drive.driveSimple()
+        struct Phase {
+            double x, y, angle;
+            uint32_t duration; // Milliseconds
+        };
+
+        // Spin both ways at two speeds, drive back and forth, then strafe while turning, with pauses in between
+        const Phase routine[] = {
+            {0, 0, 0.3, 3000}, {0, 0, 0, 500},
+            {0, 0, -0.3, 3000}, {0, 0, 0, 500},
+            {0, 0, 0.6, 2000}, {0, 0, 0, 500},
+            {0, 0, -0.6, 2000}, {0, 0, 0, 500},
+            {0, 0.3, 0, 1500}, {0, 0, 0, 500},
+            {0, -0.3, 0, 1500}, {0, 0, 0, 500},
+            {0.3, 0, 0.3, 2000}, {0, 0, 0, 500},
+            {-0.3, 0, -0.3, 2000}, {0, 0, 0, 500}
+        };
+    }
+
+    Result run() {
+        Result result = {};
+        // The motors don't move while disabled, and the driver holds the drive the rest of the time
+        if (pros::competition::is_disabled()) {
+            localStorage.log("Odometry calibration needs the robot enabled");
+            return result;
+        }
+        ActuatorLease lease(ACTUATOR_DRIVE, ARBITER_PRIORITY_TUNING, "odometry calibration");
+        if (!lease.holdsAny()) {
+            localStorage.log("Odometry calibration couldn't get the drive");
+            return result;
+        }
+
+        bool odometryWasRunning = odometry.taskRunning;
+        odometry.endTask();
+        localStorage.log("Starting odometry calibration");
+        FILE *logFile = pros::usd::is_installed() ? fopen(CALIBRATION_LOG_FILE, "w") : NULL;
+        if (logFile != NULL)
+            fprintf(logFile, "time,left,right,back,heading,strafing\n");
+
+        std::vector<Sample> samples;
+        double lastGyro = gyroSystem.getDegrees();
+        int gyroWraps = 0;
+        drive.brake();
+        for (const Phase &phase : routine) {
+            drive.driveSimple({phase.x, phase.y, phase.angle});
+            uint32_t end = pros::millis() + phase.duration;
+            uint32_t time = pros::millis();
+            while (time < end) {
+                // Same unwrapping as odometry, so turning past ±180 degrees doesn't look like a full turn back
+                double gyro = gyroSystem.getDegrees();
+                if (gyro - lastGyro > 180)
+                    gyroWraps--;
+                else if (gyro - lastGyro < -180)
+                    gyroWraps++;
+                lastGyro = gyro;
+
+                Sample sample = {leftEnc.get(), rightEnc.get(), backEnc.get(), d2r(gyroWraps * 360 + gyro), phase.x != 0};
+                samples.push_back(sample);
+                if (logFile != NULL)
+                    fprintf(logFile, "%lu,%.0f,%.0f,%.0f,%f,%u\n", (long unsigned int)time, sample.left, sample.right,
+                            sample.back, sample.heading, sample.strafing);
+                pros::Task::delay_until(&time, CALIBRATION_SAMPLE_MS);
+            }
+        }
+        drive.moveRPM(0);
+        if (logFile != NULL)
+            fclose(logFile);
+
+        result = solve(samples);
+        char logBuf[150];
+        sprintf(logBuf, "Odometry calibration %s: width %.3f (rms %.3f), back offset %.3f (rms %.3f), right scale %.4f",
+                result.valid ? "done" : "rejected", result.trackingWidth, result.widthResidual, result.backToCenter,
+                result.backResidual, result.rightWheelScale);
+        localStorage.log(logBuf);
+
+        if (result.valid) {
+            robotConfigs.trackingWidth = result.trackingWidth;
+            robotConfigs.backToCenter = result.backToCenter;
+            robotConfigs.rightWheelScale = result.rightWheelScale;
+            localStorage.writeConfigs();
+        }
+        if (odometryWasRunning)
+            odometry.startTask();
+        return result;
+    }
+}
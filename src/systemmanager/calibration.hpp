@@ -0,0 +1,52 @@
+#ifndef _CALIBRATION_HPP_INCLUDED
+#define _CALIBRATION_HPP_INCLUDED
+
+#include <vector>
+
+/*
+ * Measures the odometry constants that are hard to measure with a ruler.
+ *
+ * The robot spins, drives and strafes in place through a scripted routine while the tracking wheels and the IMU are
+ * logged. The IMU is used as the reference for how far the robot turned, and the constants are fitted to it with
+ * least squares.
+ *
+ * The absolute size of the tracking wheels can't be found this way, as nothing measures how far the robot moved.
+ * The left wheel is taken as the reference, and the right wheel is calibrated relative to it.
+ */
+namespace calibration {
+    /// One reading of the tracking wheels and the IMU.
+    struct Sample {
+        double left, right, back; // Raw encoder ticks
+        double heading;           // IMU heading in radians, unwrapped, positive clockwise
+        bool strafing;            // The robot was moving sideways, so the back wheel didn't only roll from turning
+    };
+
+    struct Result {
+        bool valid;             // False if the data wasn't good enough to trust the numbers below
+        double trackingWidth;   // Distance between the left and right tracking wheels in inches
+        double backToCenter;    // Distance between the back tracking wheel and the tracking center in inches
+        double rightWheelScale; // Effective diameter of the right tracking wheel relative to the left one
+        double widthResidual;   // RMS error of the left/right fit, in inches per window
+        double backResidual;    // RMS error of the back wheel fit, in inches per window
+    };
+
+    /**
+     * Fits the odometry constants to logged data. Doesn't use any PROS calls.
+     *
+     * \param samples The readings, in order, taken at a fixed rate.
+     *
+     * \return The fitted constants.
+     */
+    Result solve(const std::vector<Sample> &samples);
+
+    /**
+     * Drives the calibration routine, fits the constants and saves them to the SD card config if they look sane.
+     * Takes about 20 seconds and needs a couple of feet of clear space around the robot.
+     * Odometry picks the new constants up the next time its task starts.
+     * Needs the robot enabled. Takes the drive from the driver with ARBITER_PRIORITY_TUNING until it's done.
+     *
+     * \return The fitted constants.
+     */
+    Result run();
+}
+#endif /* _CALIBRATION_HPP_INCLUDED */
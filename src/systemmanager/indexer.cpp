@@ -8,28 +8,31 @@
 // Do not reference in competition code!
 void Indexer::debugIn() {
     intake.moveVelocity(-200);
-    lowerRoller.moveVelocity(-100);
-    upperRoller.moveVelocity(-50);
+    motorCommander.moveVelocity(lowerRoller, -100);
+    motorCommander.moveVelocity(upperRoller, -50);
 }
 
 void Indexer::debugOut() {
     intake.moveVelocity(200);
-    lowerRoller.moveVelocity(300);
-    upperRoller.moveVelocity(50);
+    motorCommander.moveVelocity(lowerRoller, 300);
+    motorCommander.moveVelocity(upperRoller, 50);
 }
 
 void Indexer::debugStop() {
     intake.moveVelocity(0);
-    rollerMtrGrp.moveVelocity(0);
+    motorCommander.apply(MotorCommander::VELOCITY, {{upperRoller, 0}, {lowerRoller, 0}});
 }
 
 /* ---------- INDEXER CONTROL METHODS ---------- */
-bool Indexer::checkTimeout(uint32_t timeout, uint32_t delay) {
+bool Indexer::checkTimeout(uint32_t timeout, ActuatorLease &lease, uint32_t delay) {
     pros::delay(delay);
+    // Nothing left to do once a higher priority job has all the motors, instead of waiting out the timeout
+    if(!lease.holdsAny())
+        return true;
     if((timeout + taskStartTime) < pros::millis()) {
         intake.moveVelocity(0);
-        upperRoller.moveVelocity(0);
-        lowerRoller.moveVelocity(0);
+        motorCommander.moveVelocity(upperRoller, 0);
+        motorCommander.moveVelocity(lowerRoller, 0);
         return true;
     } else
         return false;
@@ -41,33 +44,35 @@ void Indexer::getUpperBall(uint32_t timeout) {
     if(gotUpperBall)
         return;
 
+    ActuatorLease lease(ACTUATOR_INTAKE | ACTUATOR_LOWER_ROLLER | ACTUATOR_UPPER_ROLLER, ARBITER_PRIORITY_BACKGROUND,
+                        "getUpperBall");
     intake.moveVelocity(-200);
-    lowerRoller.moveVelocity(-300);
-    upperRoller.moveVelocity(-200);
+    motorCommander.moveVelocity(lowerRoller, -300);
+    motorCommander.moveVelocity(upperRoller, -200);
     
     if(!gotLowerBall)
         while(frontIndexer.get_value() > INDEXER_FRONT_DETECTION_THRESHOLD &&
               backIndexer.get_value() > INDEXER_BACK_DETECTION_THRESHOLD)
         {
-            if(checkTimeout(timeout))
+            if(checkTimeout(timeout, lease))
                 return;
         }
 
     intake.moveVelocity(0);
 
     while(backIndexer.get_value() > INDEXER_BACK_DETECTION_THRESHOLD)
-        if(checkTimeout(timeout))
+        if(checkTimeout(timeout, lease))
             return;
 
     while(backIndexer.get_value() < INDEXER_BACK_DETECTION_THRESHOLD2)
-        if(checkTimeout(timeout))
+        if(checkTimeout(timeout, lease))
             return;
     pros::delay(150);
 
     gotLowerBall = false;
     gotUpperBall = true;
-    upperRoller.moveVelocity(0);
-    lowerRoller.moveVelocity(0);
+    motorCommander.moveVelocity(upperRoller, 0);
+    motorCommander.moveVelocity(lowerRoller, 0);
 }
 
 void Indexer::getLowerBall(uint32_t timeout) {
@@ -75,21 +80,23 @@ void Indexer::getLowerBall(uint32_t timeout) {
     if(gotLowerBall)
         return;
 
+    ActuatorLease lease(ACTUATOR_INTAKE | ACTUATOR_LOWER_ROLLER, ARBITER_PRIORITY_BACKGROUND, "getLowerBall");
     intake.moveVelocity(-200);
-    lowerRoller.moveVelocity(-250);
+    motorCommander.moveVelocity(lowerRoller, -250);
 
     while(!gotLowerBall) {
         if(frontIndexer.get_value() < INDEXER_FRONT_DETECTION_THRESHOLD)
             gotLowerBall = true;
-        if(checkTimeout(timeout))
+        if(checkTimeout(timeout, lease))
             return;
     }
     intake.moveVelocity(0);
-    lowerRoller.moveVelocity(0);
+    motorCommander.moveVelocity(lowerRoller, 0);
 }
 
 void Indexer::getIntakeBall(uint32_t timeout) {
     bool gotIntakeBall = false;
+    ActuatorLease lease(ACTUATOR_INTAKE, ARBITER_PRIORITY_BACKGROUND, "getIntakeBall");
     intake.moveVelocity(-100);
     while(!gotIntakeBall) {
         if(visionSensorLower.sensor.get_object_count() > 0) {
@@ -100,30 +107,63 @@ void Indexer::getIntakeBall(uint32_t timeout) {
                 gotIntakeBall = true;
             }
         }
-        if(checkTimeout(timeout, 20))
+        if(checkTimeout(timeout, lease, 20))
             return;
     }
 }
 
+void Indexer::getUpperBallAsync(uint32_t timeout) {
+    // Counted before the task starts so isDone() is false from the moment this returns
+    jobs.start();
+    util::runAsync([this, timeout] {
+        getUpperBall(timeout);
+        jobs.finish();
+    });
+}
+
+void Indexer::getLowerBallAsync(uint32_t timeout) {
+    jobs.start();
+    util::runAsync([this, timeout] {
+        getLowerBall(timeout);
+        jobs.finish();
+    });
+}
+
+bool Indexer::isDone() {
+    return jobs.isDone();
+}
+
+bool Indexer::waitUntilDone(int timeout) {
+    return jobs.wait(timeout);
+}
+
+util::Completion& Indexer::completion() {
+    return jobs;
+}
+
 void Indexer::score(double speed) {
     speed = std::clamp(speed, 0.0, 1.0);
     if(gotUpperBall) {
         upperRoller.moveRelative(-1200, 600*speed);
+        motorCommander.invalidate(upperRoller);
         gotUpperBall = false;
     }
     else if(gotLowerBall) {
         lowerRoller.moveRelative(-1200, 600*speed);
         upperRoller.moveRelative(-2400, 600*speed);
+        motorCommander.invalidate(lowerRoller);
+        motorCommander.invalidate(upperRoller);
         gotLowerBall = false;
     }
 }
 
 void Indexer::discardLowerBall() {
+    ActuatorLease lease(ACTUATOR_INTAKE | ACTUATOR_LOWER_ROLLER, ARBITER_PRIORITY_BACKGROUND, "discardLowerBall");
     intake.moveVelocity(200);
-    lowerRoller.moveVelocity(400);
+    motorCommander.moveVelocity(lowerRoller, 400);
     pros::delay(600);
     intake.moveVelocity(0);
-    lowerRoller.moveVelocity(0);
+    motorCommander.moveVelocity(lowerRoller, 0);
     gotLowerBall = false;
 }
 
@@ -6,6 +6,8 @@
 
 #include "api.h"
 #include "profiles.hpp"
+#include "util/completion.hpp"
+#include "subsystem/arbiter.hpp"
 #include <algorithm>
 
 #define DEFAULT_INDEXER_TIMEOUT 4000
@@ -13,8 +15,10 @@
 class Indexer {
 private:
     uint32_t taskStartTime;
-    // Returns true if task has exceeded timeout
-    bool checkTimeout(uint32_t timeout, uint32_t delay = 10);
+    /// Counts the jobs started by the async functions. Wakes up the tasks in waitUntilDone when the last one ends.
+    util::Completion jobs;
+    // Returns true if task has exceeded timeout, or if other jobs took every motor it was using
+    bool checkTimeout(uint32_t timeout, ActuatorLease &lease, uint32_t delay = 10);
     
 public:
     bool gotUpperBall = false, gotLowerBall = false;
@@ -61,6 +65,30 @@ class Indexer {
      * \param timeout Timeout for getting both balls combined miliseconds.
      */
     void getAllBalls(uint32_t timeout = DEFAULT_INDEXER_TIMEOUT);
+    /**
+     * Runs getUpperBall in its own task. Use waitUntilDone to block until it's finished.
+     *
+     * \param timeout Timeout for attempting to get a ball in miliseconds.
+     */
+    void getUpperBallAsync(uint32_t timeout = DEFAULT_INDEXER_TIMEOUT);
+    /**
+     * Runs getLowerBall in its own task. Use waitUntilDone to block until it's finished.
+     *
+     * \param timeout Timeout for attempting to get a ball in miliseconds.
+     */
+    void getLowerBallAsync(uint32_t timeout = DEFAULT_INDEXER_TIMEOUT);
+    /// \return True if none of the functions started asynchronously are still running.
+    bool isDone();
+    /**
+     * Blocks until the functions started asynchronously have finished. Woken up as soon as the last one ends.
+     *
+     * \param timeout The maximum time to wait in milliseconds, or NO_TIME_OUT to wait as long as it takes.
+     *
+     * \return True if they finished, false if it timed out.
+     */
+    bool waitUntilDone(int timeout = NO_TIME_OUT);
+    /// \return The Completion finished when the last asynchronous function ends, for util::runAsBlocking.
+    util::Completion& completion();
     /// Ejects ball in the intake of the robot. Used after descore.
     void discardLowerBall();
     /**
@@ -0,0 +1,95 @@
+#include "motorodometry.hpp"
+
+/*
+x: ⬅️ negative, ➡️ positive
+y: ⬇️ negative, ⬆️ positive
+a: ↩️ positive, ↪️ negative
+*/
+
+MotorOdometry::MotorOdometry(const Eigen::Matrix<double, 4, 3> &inverseKinematics)
+    : forwardKinematics(inverseKinematics) {
+}
+
+void MotorOdometry::reset(util::ChassisPos start, util::WheelSpeed distances, const OdometrySample &sample) {
+    pos = start;
+    lastDistances = distances;
+    lastMove = {0, 0, 0};
+    lastTwist = {0, 0, 0};
+    lastTicks[0] = sample.left;
+    lastTicks[1] = sample.right;
+    lastTicks[2] = sample.back;
+    for (double &travel : expectedTravel)
+        travel = 0;
+    unplugged = 0;
+}
+
+void MotorOdometry::setPos(util::ChassisPos newPos) {
+    pos = newPos;
+}
+
+bool MotorOdometry::step(util::WheelSpeed distances, double mirror, double heading) {
+    util::WheelSpeed moved = {distances.lf - lastDistances.lf, distances.lr - lastDistances.lr,
+                              distances.rf - lastDistances.rf, distances.rr - lastDistances.rr};
+    lastDistances = distances;
+
+    // Same as the tracking wheels, a jump means the encoders were reset or a reading went wrong
+    if (std::fabs(moved.lf) > ODOM_MOTOR_MAX_STEP_IN || std::fabs(moved.lr) > ODOM_MOTOR_MAX_STEP_IN ||
+        std::fabs(moved.rf) > ODOM_MOTOR_MAX_STEP_IN || std::fabs(moved.rr) > ODOM_MOTOR_MAX_STEP_IN) {
+        lastMove = lastTwist = {0, 0, 0};
+        return false;
+    }
+
+    // How far the robot moved relative to itself. Over one 10ms step the arc is small enough to treat as a line
+    lastMove = forwardKinematics.toChassisSpeed(moved);
+    double dX = lastMove.x * mirror;
+    double newA = std::isnan(heading) ? pos.angle + lastMove.angle * mirror : heading;
+    double mA = (pos.angle + newA) / 2.0;
+
+    double cosMA = std::cos(mA);
+    double sinMA = std::sin(mA);
+    pos.x += (lastMove.y * sinMA) + (dX * cosMA);
+    pos.y += (lastMove.y * cosMA) + (dX * -sinMA);
+
+    // The rotation always comes from the drive wheels, so a filter that gets the heading from elsewhere can predict with it
+    lastTwist = {dX, lastMove.y, lastMove.angle * mirror};
+    pos.angle = newA;
+    return true;
+}
+
+uint8_t MotorOdometry::checkTrackingWheels(const OdometrySample &sample, const OdometryConfig &config) {
+    double ticks[3] = {sample.left, sample.right, sample.back};
+    // How far each tracking wheel should have rolled during the last step, from the unmirrored drive wheel movement
+    double expected[3] = {lastMove.y + lastMove.angle * config.chassisWidth / 2.0,
+                          lastMove.y - lastMove.angle * config.chassisWidth / 2.0,
+                          lastMove.x - lastMove.angle * config.backToCenter};
+
+    bool changed[3];
+    for (int i = 0; i < 3; i++)
+        changed[i] = ticks[i] != lastTicks[i];
+
+    for (int i = 0; i < 3; i++) {
+        if (changed[i]) {
+            expectedTravel[i] = 0;
+            unplugged &= ~(1 << i);
+        } else if (changed[(i + 1) % 3] || changed[(i + 2) % 3]) {
+            // Only counts while another tracking wheel agrees the robot is really moving
+            expectedTravel[i] += std::fabs(expected[i]);
+            if (expectedTravel[i] > ODOM_UNPLUGGED_TRAVEL_IN)
+                unplugged |= 1 << i;
+        }
+        lastTicks[i] = ticks[i];
+    }
+    return unplugged;
+}
+
+util::ChassisPos MotorOdometry::getPos() {
+    return pos;
+}
+
+util::ChassisSpeed MotorOdometry::getLastTwist() {
+    return lastTwist;
+}
+
+uint8_t MotorOdometry::getUnpluggedWheels() {
+    return unplugged;
+}
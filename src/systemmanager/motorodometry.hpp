@@ -0,0 +1,103 @@
+// Odometry from the drive motor encoders. Only the math, the odometry task reads the sensors and feeds it
+
+#ifndef _MOTORODOMETRY_HPP_INCLUDED
+#define _MOTORODOMETRY_HPP_INCLUDED
+
+#include <cmath>
+#include <cstdint>
+#include "profiles.hpp"
+#include "util/struct.hpp"
+#include "util/math/drivekinematics.hpp"
+#include "systemmanager/odometrystep.hpp"
+
+/// Flags for the tracking wheels in MotorOdometry::getUnpluggedWheels()
+enum TrackingWheel : uint8_t {
+    TRACKING_LEFT = 1 << 0,
+    TRACKING_RIGHT = 1 << 1,
+    TRACKING_BACK = 1 << 2
+};
+
+/**
+ * A second position estimate from the four drive motor encoders, through ForwardKinematics.
+ *
+ * The drive wheels slip far more than the tracking wheels, so this drifts and isn't meant to replace them.
+ * It keeps odometry going when a tracking wheel gets unplugged, and gives something to cross-check them against.
+ * Stepped at the rate the motors report new positions, every ODOM_MOTOR_PERIOD_US.
+ */
+class MotorOdometry {
+private:
+    util::ForwardKinematics forwardKinematics;
+    util::WheelSpeed lastDistances = {0, 0, 0, 0};
+    // Field position, angle in radians
+    util::ChassisPos pos = {0, 0, 0};
+    util::ChassisSpeed lastMove = {0, 0, 0};
+    util::ChassisSpeed lastTwist = {0, 0, 0};
+
+    // Tracking wheel ticks at the last step, and how far each should have rolled since it last changed
+    double lastTicks[3] = {0, 0, 0};
+    double expectedTravel[3] = {0, 0, 0};
+    uint8_t unplugged = 0;
+
+public:
+    /**
+     * \param inverseKinematics The drive's inverse kinematics matrix, from DriveSubsystem::getIKMatrix().
+     */
+    MotorOdometry(const Eigen::Matrix<double, 4, 3> &inverseKinematics);
+
+    /**
+     * Continues from a known position.
+     *
+     * \param start The position, angle in radians.
+     *
+     * \param distances How far each drive wheel has rolled so far, from DriveSubsystem::getWheelDistances().
+     *
+     * \param sample The tracking wheel values at the same time, for the unplugged check.
+     */
+    void reset(util::ChassisPos start, util::WheelSpeed distances, const OdometrySample &sample);
+
+    /**
+     * Moves the position without touching anything else, e.g. to pick up from the tracking wheel position.
+     *
+     * \param newPos The position, angle in radians.
+     */
+    void setPos(util::ChassisPos newPos);
+
+    /**
+     * Integrates one new set of drive wheel distances into the position.
+     *
+     * \param distances How far each drive wheel has rolled, from DriveSubsystem::getWheelDistances().
+     *
+     * \param mirror 1 on the red side, -1 on the blue side, like the tracking wheels.
+     *
+     * \param heading The field heading in radians from a sensor that doesn't slip, like the IMU.
+     * NAN to integrate the heading from the drive wheels as well.
+     *
+     * \return False if a wheel jumped unreasonably far and the step was thrown away, like after the encoders were reset.
+     */
+    bool step(util::WheelSpeed distances, double mirror, double heading = NAN);
+
+    /**
+     * Compares the tracking wheels against the last step. A tracking wheel that doesn't change while the drive
+     * wheels and another tracking wheel say the robot moved at least ODOM_UNPLUGGED_TRAVEL_IN past it is
+     * marked unplugged, until it changes again.
+     * Pushing against something doesn't trip it, since the other tracking wheels stand still as well then.
+     *
+     * \param sample The tracking wheel values at the time of the last step.
+     *
+     * \param config The tracking wheel geometry.
+     *
+     * \return TrackingWheel flags of the wheels that look unplugged.
+     */
+    uint8_t checkTrackingWheels(const OdometrySample &sample, const OdometryConfig &config);
+
+    /// \return The field position, angle in radians.
+    util::ChassisPos getPos();
+
+    /// \return The last step as a twist in the robot's frame after mirroring, like OdometryState::lastTwist.
+    /// The angle is what the drive wheels turned, even when the heading comes from elsewhere.
+    util::ChassisSpeed getLastTwist();
+
+    /// \return TrackingWheel flags from the last checkTrackingWheels().
+    uint8_t getUnpluggedWheels();
+};
+#endif /* _MOTORODOMETRY_HPP_INCLUDED */
@@ -12,28 +12,22 @@ a: ↩️ positive, ↪️ negative
 Odometry::Odometry() {
 }
 
-void Odometry::useGyroRotation(){
+void Odometry::useGyroRotation(bool wait){
     if(gyroRotation) return;
-    bool taskWasRunning = taskRunning;
-    if(taskWasRunning)
-        endTask();
-    pros::delay(20);
-    zeroPosA =  d2r(gyroSystem.getDegrees()) - data.angle;
     gyroRotation = true;
-    if(taskWasRunning)
-        startTask();
+    send({OdometryCommand::CONFIGURE}, wait);
 }
 
-void Odometry::useEncoderRotation(){
+void Odometry::useEncoderRotation(bool wait){
     if(!gyroRotation)return;
-    bool taskWasRunning = taskRunning;
-    if(taskWasRunning)
-        endTask();
-    pros::delay(20);
-    zeroPosA = ((leftEnc.get() - rightEnc.get()) * SIDE_ENC_TO_IN / ENC_BASE_WIDTH_IN) - data.angle;
     gyroRotation = false;
-    if(taskWasRunning)
-        startTask();
+    send({OdometryCommand::CONFIGURE}, wait);
+}
+
+void Odometry::useEKF(bool enable, bool wait){
+    if(ekf == enable) return;
+    ekf = enable;
+    send({OdometryCommand::CONFIGURE}, wait);
 }
 
 void Odometry::resetForAuton() {
@@ -49,136 +43,368 @@ void Odometry::resetForAuton() {
     }
 }
 
-void Odometry::reset(util::ChassisPos originPoint, bool hardware) {
-    bool taskWasRunning = taskRunning;
-    if (taskWasRunning)
-        endTask();
-    pros::delay(20);
-    data.x = originPoint.x;
-    data.y = originPoint.y;
-    data.angle = d2r(originPoint.angle);
-    zeroPosA = d2r(gyroSystem.getDegrees() - originPoint.angle);
-    if (hardware) {
-        drive.resetEncoders();
-        backEnc.reset();
-        leftEnc.reset();
-        rightEnc.reset();
+void Odometry::reset(util::ChassisPos originPoint, bool hardware, bool wait) {
+    send({OdometryCommand::RESET, {originPoint.x, originPoint.y, d2r(originPoint.angle)}, hardware}, wait);
+}
+
+bool Odometry::send(OdometryCommand command, bool wait) {
+    if (!taskRunning) {
+        applyDirectly(command);
+        return true;
     }
-    pros::delay(20);
-    if (taskWasRunning)
-        startTask();
-}
-
-void odometryTaskFn(void *param) {
-    //Initialize the "last" encoder values
-    double lastL = leftEnc.get();
-    double lastR = rightEnc.get();
-    double lastB = backEnc.get();
-
-    //Initialize heading related values
-    double lastA, lastGyro, newGyro;
-    int gyroCounter = 0;
-    if(odometry.gyroRotation) {
-        lastA = lastGyro = d2r(gyroSystem.getDegrees()) - odometry.zeroPosA;
-    } else {
-        lastA = odometry.getPos().angle * (robotConfigs.autonSide & LocalStorage::AutonMode::RED ? 1.0 : -1.0);
+
+    command.caller = wait ? pros::c::task_get_current() : NULL;
+    // Numbered and queued in one go, so a later number can't be applied before this one
+    pros::c::mutex_take(sendMutex, TIMEOUT_MAX);
+    command.sequence = ++queued;
+    bool sent = pros::c::queue_append(commands, &command, ODOM_COMMAND_TIMEOUT);
+    pros::c::mutex_give(sendMutex);
+    if (!sent) {
+        localStorage.log("Odometry command queue is full");
+        return false;
     }
+    if (!wait)
+        return true;
+
+    // The notification slot is shared with util::Completion and anything else that notifies this task,
+    // so a wake up only means something happened. Done once this command's number was applied
+    uint32_t start = pros::millis(), elapsed;
+    while ((int32_t)(applied.load() - command.sequence) < 0) {
+        elapsed = pros::millis() - start;
+        if (elapsed >= ODOM_COMMAND_TIMEOUT)
+            return false;
+        pros::c::task_notify_take(true, ODOM_COMMAND_TIMEOUT - elapsed);
+    }
+    return true;
+}
+
+void Odometry::applyDirectly(const OdometryCommand &command) {
+    OdometryConfig config = getConfig();
+    util::ChassisPos pos = getPos();
+    switch (command.type) {
+        case OdometryCommand::RESET:
+            if (command.hardware) {
+                drive.resetEncoders();
+                backEnc.reset();
+                leftEnc.reset();
+                rightEnc.reset();
+            }
+            pos = command.pos;
+            break;
+        case OdometryCommand::RELOCALIZE:
+            pos = field::relocalize(*command.landmark, pos, command.headingOffset);
+            break;
+        case OdometryCommand::CONFIGURE:
+            break;
+    }
+    // The task picks the heading up from zeroPosA when it starts. Tracking wheel heading lines itself up
+    zeroPosA = d2r(gyroSystem.getDegrees()) - pos.angle * (config.redSide ? 1.0 : -1.0);
+    setPos(pos);
+    history.clear(); // Old poses are in a different frame now
+}
 
-    double curL, curR, curB, dL, dR, dB, newA, dA, dX, dY, mA, chassisWidth, r, r2, i, sinI, cosMA, sinMA;
+OdometryConfig Odometry::getConfig() {
+    OdometryConfig config;
+    // Measured by the calibration routine and saved to the SD card, defaults to the constants in profiles.hpp
+    config.chassisWidth = robotConfigs.trackingWidth;
+    config.backToCenter = robotConfigs.backToCenter;
+    config.rightEncToIn = config.leftEncToIn * robotConfigs.rightWheelScale;
+    config.gyroRotation = gyroRotation;
+    config.redSide = robotConfigs.autonSide & LocalStorage::AutonMode::RED;
+    return config;
+}
+
+/// Reads every sensor odometry uses. The gyro is skipped when it isn't needed as polling it isn't free.
+static OdometrySample readOdometrySensors(bool readGyro) {
+    return {util::micros(), leftEnc.get(), rightEnc.get(), backEnc.get(), readGyro ? gyroSystem.getDegrees() : 0};
+}
+
+/// Heading of an X-drive from the distance its left and right wheels rolled. Slips a lot, but never drifts on its own.
+static double driveHeading(util::WheelSpeed wheels) {
+    return (util::avgDouble(wheels.lf, wheels.lr) - util::avgDouble(wheels.rf, wheels.rr)) /
+           (M_SQRT2 * (BASE_LENGTH_IN + BASE_WIDTH_IN) / 2.0);
+}
+
+void Odometry::odometryTaskFn(void *param) {
+    Odometry *odom = (Odometry *)param;
+    OdometryConfig config = odom->getConfig();
+    bool useFilter = odom->ekf;
+    // With the filter on, the tracking wheels only provide movement. The IMU gets fused in by the filter
+    if (useFilter)
+        config.gyroRotation = false;
+    double mirror = config.redSide ? 1.0 : -1.0;
+
+    //Getting the current position from the odometry class
+    PoseSnapshot snapshot = odom->getSnapshot();
+
+    //Initialize the "last" values from the current sensor readings
+    OdometryState state;
+    OdometrySample sample = readOdometrySensors(useFilter || config.gyroRotation || odom->recorder.isRecording());
+    initOdometry(state, sample, config, snapshot.pos, odom->zeroPosA);
+    odom->recorder.recordStart(state, config, sample.timestamp);
+    odom->recorder.recordSample(sample);
+
+    // Drive motor distances, read every ODOM_MOTOR_PERIOD_US and shared by everything below that needs them
+    util::WheelSpeed motorWheels = drive.getWheelDistances(), newMotorWheels;
+
+    // Filter related values. The IMU and drive headings are unwrapped and mirrored the same way odometry is
+    PoseEKF filter;
+    filter.reset(snapshot.pos);
+    double lastGyro = sample.gyro, imuHeading;
+    int gyroWraps = 0;
+    double lastDriveHeading = driveHeading(motorWheels) * mirror, newDriveHeading;
+    double headingAtLastDrive = snapshot.pos.angle;
+    // When the tracking wheel movement in state.lastTwist started, and how long it took
+    uint64_t twistStart = sample.timestamp;
+    double twistSeconds, yawRate;
 
-    //Getting the current position from the odometry class, as the task function is not a member of the class
-	double x = odometry.getPos().x, y = odometry.getPos().y, angle = lastA;
+    util::VelocityEstimator velocity(odom->velocityFilter);
+    velocity.reset(snapshot.pos, sample.timestamp);
 
+    // Second estimate from the drive motors, stepped whenever they report new positions
+    MotorOdometry motorOdom(drive.getIKMatrix());
+    motorOdom.reset(snapshot.pos, motorWheels, sample);
+    SlipDetector slipDetector(drive.getIKMatrix());
+    slipDetector.reset(motorWheels, sample.timestamp);
+    odom->slip.write(slipDetector.get());
+    uint64_t lastMotorRead = sample.timestamp;
+    bool motorsChanged = false, motorStepped = false, fallback = false;
+    char logBuf[100];
+
+    // Starts everything over from a new position, using the sensor values in sample
+    auto restart = [&](util::ChassisPos pos) {
+        sample.gyro = gyroSystem.getDegrees();
+        odom->zeroPosA = d2r(sample.gyro) - pos.angle * mirror;
+        initOdometry(state, sample, config, pos, odom->zeroPosA);
+        filter.reset(pos);
+        twistStart = sample.timestamp;
+        lastGyro = sample.gyro;
+        gyroWraps = 0;
+        motorWheels = drive.getWheelDistances();
+        lastDriveHeading = driveHeading(motorWheels) * mirror;
+        headingAtLastDrive = pos.angle;
+        velocity.reset(pos, sample.timestamp);
+        motorOdom.reset(pos, motorWheels, sample);
+        slipDetector.reset(motorWheels, sample.timestamp);
+        odom->slip.write(slipDetector.get());
+        fallback = false;
+        odom->history.clear(); // Old poses are in a different frame now
+        odom->setPos(pos);
+        odom->recorder.recordStart(state, config, sample.timestamp);
+    };
+
+    // Sensor freshness. The ADI and smart ports refresh slower than this loop, so most reads return the same values
+    OdometryStats stats = {};
+    OdometrySample last = sample;
+    uint64_t lastEncoderChange = sample.timestamp, lastGyroChange = sample.timestamp, lastStep = sample.timestamp;
+    uint32_t encoderChangeMillis = pros::millis();
+    bool encodersChanged = false, gyroChanged = false;
+
+    // Waits for the next cycle depending on the loop mode
     uint32_t time;
+    auto sleep = [&]() {
+        time = pros::millis();
+        if (odom->loopMode == Odometry::PHASE_LOCKED && encodersChanged) {
+            // Just caught an ADI update, nothing new will show up until right before the next one
+            time = encoderChangeMillis;
+            pros::Task::delay_until(&time, ODOM_ADI_PERIOD_MS - 1);
+        } else {
+            pros::Task::delay_until(&time, odom->delay); // TODO: try shorter time?
+        }
+    };
+
+    OdometryCommand command;
+    util::ChassisPos current;
+    bool updated;
     pros::delay(20);
     while (true) {
-        //Storing the encoder values in a local variable
-        curL = leftEnc.get();
-        curR = rightEnc.get();
-        curB = backEnc.get();
-
-        //Calculating the amount each tracking wheel as moved, in inches
-        dL = (curL - lastL) * SIDE_ENC_TO_IN; // amount left side moved
-        dR = (curR - lastR) * SIDE_ENC_TO_IN; // amount right side moved
-        dB = (curB - lastB) * BACK_ENC_TO_IN; // amount back tracking wheel moved
-
-        // If moving unreasonably fast, just ignore the inputs.
-        // This might happen at the start of the program, or when the encoders somehow gets reset
-        if (fabs(dL) > 1 || fabs(dR) > 1 || fabs(dB) > 1) {
-            lastL = curL;
-            lastR = curR;
-            lastB = curB;
-            pros::delay(5);
-            continue;
+        sample = readOdometrySensors(useFilter || config.gyroRotation || odom->recorder.isRecording());
+
+        encodersChanged = sample.left != last.left || sample.right != last.right || sample.back != last.back;
+        gyroChanged = sample.gyro != last.gyro;
+        // Gaps longer than 50ms mean the robot was sitting still, not that the sensor is slow
+        if (encodersChanged) {
+            if (sample.timestamp - lastEncoderChange < 50000)
+                stats.encoderInterval += (sample.timestamp - lastEncoderChange - stats.encoderInterval) / 8.0;
+            lastEncoderChange = sample.timestamp;
+            encoderChangeMillis = pros::millis();
         }
+        if (gyroChanged) {
+            if (sample.timestamp - lastGyroChange < 50000)
+                stats.gyroInterval += (sample.timestamp - lastGyroChange - stats.gyroInterval) / 8.0;
+            lastGyroChange = sample.timestamp;
+        }
+        last = sample;
+        stats.cycles++;
+        if (!encodersChanged && !gyroChanged)
+            stats.duplicates++;
+        stats.encoderAge = sample.timestamp - lastEncoderChange;
+        stats.gyroAge = sample.timestamp - lastGyroChange;
 
-        //Store the chassis width to a local variable.
-        //We might experiment with changing the chassiswidth while running in the future
-        chassisWidth = ENC_BASE_WIDTH_IN;
-        
-        //Finding the new heading and difference in heading
-        if(odometry.gyroRotation) {
-            newGyro = gyroSystem.getDegrees();
-            // The gyro only goes up to ±360 degrees, but we don't want it to jump from -360 to 360
-            // We detect when this happens and makes the rotation continuous by adding the correct amount of rotation to it
-            if (abs(lastGyro - newGyro) > 180 && abs(newGyro) > 100 &&
-                abs(lastGyro) > 100 && signbit(newGyro) != signbit(lastGyro))
-            {
-                if (signbit(newGyro)) // counter clockwise
-                    gyroCounter--;
-                else // clockwise
-                    gyroCounter++;
+        // Commands are applied between two steps, so the task never has to stop and lose sensor readings
+        while (pros::c::queue_recv(odom->commands, &command, 0)) {
+            current = useFilter ? filter.getPos() : util::ChassisPos{state.x, state.y, state.angle};
+            switch (command.type) {
+                case OdometryCommand::RESET:
+                    if (command.hardware) {
+                        drive.resetEncoders();
+                        backEnc.reset();
+                        leftEnc.reset();
+                        rightEnc.reset();
+                        sample = readOdometrySensors(true);
+                    }
+                    restart(command.pos);
+                    break;
+                case OdometryCommand::RELOCALIZE:
+                    restart(field::relocalize(*command.landmark, current, command.headingOffset));
+                    break;
+                case OdometryCommand::CONFIGURE:
+                    useFilter = odom->ekf;
+                    config.gyroRotation = useFilter ? false : odom->gyroRotation;
+                    restart(current);
+                    break;
             }
-            newA = d2r(gyroCounter * 360 + newGyro) - odometry.zeroPosA;
-            dA = newA - lastA;
-        } else {
-            newA = (curL - curR) * SIDE_ENC_TO_IN / chassisWidth - odometry.zeroPosA;
-            dA = newA - lastA;
+            odom->applied = command.sequence;
+            if (command.caller != NULL)
+                pros::c::task_notify(command.caller);
         }
 
-        odometry.setChassisVel({dB * (1000.0/odometry.delay) / (MAX_SPEED_IN_S / 2), util::avgDouble(dL,dR) * (1000.0/odometry.delay) / MAX_SPEED_IN_S, dA * (1000.0/odometry.delay) / MAX_CHASSIS_RPS});
+        // The drive motors refresh slower than the ADI ports, so they're only read as often as they can change
+        motorsChanged = motorStepped = false;
+        if (sample.timestamp - lastMotorRead >= ODOM_MOTOR_PERIOD_US) {
+            lastMotorRead = sample.timestamp;
+            newMotorWheels = drive.getWheelDistances();
+            motorsChanged = newMotorWheels.lf != motorWheels.lf || newMotorWheels.lr != motorWheels.lr ||
+                            newMotorWheels.rf != motorWheels.rf || newMotorWheels.rr != motorWheels.rr;
+            motorWheels = newMotorWheels;
 
-        // http://thepilons.ca/wp-content/uploads/2018/10/Tracking.pdf
-        if (dA == 0) {
-            i = 0;
-            dX = dB;
-            dY = util::avgDouble(dL, dR);
-        } else {
-            r = dR / dA;
-            r2 = dB / dA;
-            i = dA / 2.0;
-            sinI = sin(i);
-            dX = 2 * sinI * (r2 + BACK_TO_CENTER_IN);
-            dY = 2 * sinI * (r + chassisWidth / 2.0);
+            // Slip needs the tracking wheels to compare against
+            if (fallback) {
+                slipDetector.reset(motorWheels, sample.timestamp);
+                odom->slip.write(slipDetector.get());
+            } else if (slipDetector.update(motorWheels, sample.timestamp)) {
+                odom->slip.write(slipDetector.get());
+            }
+        }
+        if (motorsChanged) {
+            // Heading from the IMU when odometry has it, from the drive wheels otherwise so the two estimates stay apart
+            motorStepped = motorOdom.step(motorWheels, mirror, useFilter || config.gyroRotation ? snapshot.pos.angle : NAN);
+            stats.unpluggedWheels = motorOdom.checkTrackingWheels(sample, config);
+
+            if ((odom->motorFallback && stats.unpluggedWheels != 0) != fallback) {
+                fallback = !fallback;
+                if (fallback) {
+                    // Picks up from the tracking wheels. Whatever the robot moved before the wheel was noticed is lost
+                    motorOdom.setPos(snapshot.pos);
+                    sprintf(logBuf, "Odometry: tracking wheel%s%s%s stopped counting, using the drive motors",
+                            stats.unpluggedWheels & TRACKING_LEFT ? " left" : "",
+                            stats.unpluggedWheels & TRACKING_RIGHT ? " right" : "",
+                            stats.unpluggedWheels & TRACKING_BACK ? " back" : "");
+                } else {
+                    // The tracking wheels continue from where the drive motors got to
+                    initOdometry(state, sample, config, snapshot.pos, odom->zeroPosA);
+                    twistStart = sample.timestamp;
+                    sprintf(logBuf, "Odometry: tracking wheels are counting again");
+                }
+                localStorage.log(logBuf);
+            }
+            stats.motorFallback = fallback;
+            snapshot.motorPos = motorOdom.getPos();
+            stats.motorDivergence = std::hypot(snapshot.motorPos.x - snapshot.pos.x, snapshot.motorPos.y - snapshot.pos.y);
+        }
+
+        // Nothing new to integrate. Still runs every so often so the velocity settles once the robot stops
+        if (odom->loopMode != Odometry::FIXED && !encodersChanged && !gyroChanged && !motorsChanged &&
+            sample.timestamp - lastStep < ODOM_MAX_SKIP_US && pros::c::queue_get_waiting(odom->commands) == 0) {
+            odom->stats.write(stats);
+            sleep();
+            continue;
         }
+        lastStep = sample.timestamp;
+        stats.steps++;
+        odom->stats.write(stats);
 
-        mA = lastA + i; // the angle between the last angle and the current angle,
-                        // assumed to be the direction the robot moved in
+        updated = stepOdometry(state, sample, config);
+        twistSeconds = (sample.timestamp - twistStart) / 1e6;
+        twistStart = sample.timestamp;
 
-        cosMA = std::cos(mA);
-        sinMA = std::sin(mA);
+        // Robot relative, unmirrored movement of the tracking center, for the slip detector
+        if (updated)
+            slipDetector.track({state.lastMove.x + state.lastMove.angle * config.backToCenter, state.lastMove.y,
+                                state.lastMove.angle});
+
+        // A recording that starts while odometry is running begins from the state after this step
+        if (odom->recorder.isStartPending())
+            odom->recorder.recordStart(state, config, sample.timestamp);
+        odom->recorder.recordSample(sample);
+
+        // Sample is thrown away if the tracking wheels jumped, which can happen when the encoders get reset
+        if (!updated) {
+            pros::delay(5);
+            continue;
+        }
+
+        if (useFilter) {
+            // While a tracking wheel is unplugged the drive motors move the filter instead, whenever they report
+            if (!fallback) {
+                filter.predict(state.lastTwist);
+                // The IMU's rate checks how far the tracking wheels say the robot turned during this step
+                yawRate = gyroSystem.getRate();
+                if (!std::isnan(yawRate))
+                    filter.updateYawRate(d2r(yawRate) * mirror, twistSeconds, EKF_IMU_RATE_VARIANCE);
+            } else if (motorStepped)
+                filter.predict(motorOdom.getLastTwist());
+
+            // The IMU and motors update slower than this loop. Only fuse readings that are actually new
+            if (sample.gyro != lastGyro) {
+                if (sample.gyro - lastGyro > 180)
+                    gyroWraps--;
+                else if (sample.gyro - lastGyro < -180)
+                    gyroWraps++;
+                lastGyro = sample.gyro;
+                imuHeading = (d2r(gyroWraps * 360 + sample.gyro) - odom->zeroPosA) * mirror;
+                filter.updateHeading(imuHeading, EKF_IMU_HEADING_VARIANCE);
+            }
+
+            // Uses the distances from the last motor read, the motors don't report anything new in between
+            newDriveHeading = driveHeading(motorWheels) * mirror;
+            if (newDriveHeading != lastDriveHeading) {
+                // The drive heading is only good for how much the robot turned, not for where it's facing
+                filter.updateHeading(headingAtLastDrive + newDriveHeading - lastDriveHeading, EKF_DRIVE_HEADING_VARIANCE);
+                lastDriveHeading = newDriveHeading;
+                headingAtLastDrive = filter.getPos().angle;
+            }
 
-        // Update the global position
-        if (robotConfigs.autonSide & LocalStorage::AutonMode::RED) {
-            angle = newA;
-            x += (dY * sinMA) + (dX * cosMA);
+            snapshot.pos = filter.getPos();
+            snapshot.covariance = filter.getCovariance();
+        } else if (fallback) {
+            snapshot.pos = motorOdom.getPos();
         } else {
-            angle = -newA;
-            x -= (dY * sinMA) + (dX * cosMA);
+            snapshot.pos = {state.x, state.y, state.angle};
         }
-        y += (dY * cosMA) + (dX * -sinMA);
 
-		odometry.setPos({x,y,angle});
+        velocity.update(snapshot.pos, sample.timestamp);
+        snapshot.fieldVel = velocity.getFieldVel();
+        snapshot.fieldAccel = velocity.getFieldAccel();
+        snapshot.robotVel = velocity.getRobotVel();
+        snapshot.robotAccel = velocity.getRobotAccel();
+        // Normalized velocity stays in the robot's own (unmirrored) directions
+        snapshot.vel = {snapshot.robotVel.x * mirror / (MAX_SPEED_IN_S / 2),
+                        snapshot.robotVel.y / MAX_SPEED_IN_S,
+                        snapshot.robotVel.angle * mirror / MAX_CHASSIS_RPS};
+
+        // Position, velocity and time are published together so readers never see a mix of two cycles
+        snapshot.timestamp = sample.timestamp;
+        odom->publish(snapshot);
 
 #ifdef ODON_LCD_LINE_2
         if (robotConfigs.debugging)
-            pros::lcd::print(ODON_LCD_LINE_2, "l: %.2f, r: %.2f, a: %.2f", curL, curR	, r2d(newA));
+            pros::lcd::print(ODON_LCD_LINE_2, "l: %.2f, r: %.2f, a: %.2f", sample.left, sample.right, r2d(state.lastA));
 #endif
 
 #ifdef ODON_LCD_LINE
         if (robotConfigs.debugging)
-            pros::lcd::print(ODON_LCD_LINE, "x: %.2f, y: %.2f, a: %.2f", odometry.getPos().x,
-                             odometry.getPos().y, r2d(odometry.getPos().angle));
+            pros::lcd::print(ODON_LCD_LINE, "x: %.2f, y: %.2f, a: %.2f", snapshot.pos.x, snapshot.pos.y, r2d(snapshot.pos.angle));
 #endif
 
         // char logBuf[80];
@@ -186,19 +412,33 @@ void odometryTaskFn(void *param) {
         //         odometry.getPos().x, odometry.getPos().y, r2d(odometry.getPos().angle));
         // localStorage.log(logBuf);
 
-        //Updating the "Last" values
-        lastA = newA;
-        lastL = curL;
-        lastR = curR;
-        lastB = curB;
-
-        time = pros::millis();
-        pros::Task::delay_until(&time, odometry.delay); // TODO: try shorter time?
+        sleep();
     }
 }
 
+util::ChassisPos Odometry::relocalizeAgainst(const field::Landmark &landmark, double headingOffset) {
+    OdometryCommand command = {OdometryCommand::RELOCALIZE};
+    command.landmark = &landmark;
+    command.headingOffset = d2r(headingOffset);
+    send(command, true);
+    return getPos();
+}
+
+bool Odometry::startRecording(const char *filename) {
+    return recorder.start(filename, getConfig());
+}
+
+void Odometry::stopRecording() {
+    recorder.stop();
+}
+
 void Odometry::startTask() {
     if (!taskRunning) {
+        if (commands == NULL) {
+            commands = pros::c::queue_create(ODOM_COMMAND_QUEUE_LENGTH, sizeof(OdometryCommand));
+            sendMutex = pros::c::mutex_create();
+        }
+        pros::c::queue_reset(commands); // Anything left over was meant for the last task
         taskRunning = true;
         odoTask = pros::c::task_create(odometryTaskFn, this, TASK_PRIORITY_DEFAULT,
                                        TASK_STACK_DEPTH_DEFAULT, "odometry task");
@@ -213,17 +453,41 @@ void Odometry::endTask() {
 }
 
 util::ChassisPos Odometry::getPos(){
-	return data;
+	return pose.read().pos;
 }
 
 void Odometry::setPos(util::ChassisPos pos){
-	data = pos;
+    PoseSnapshot snapshot = pose.read();
+    snapshot.pos = pos;
+    snapshot.timestamp = util::micros();
+	pose.write(snapshot);
 }
 
 util::ChassisSpeed Odometry::getChassisVel(){
-    return localVel;
+    return pose.read().vel;
+}
+
+PoseSnapshot Odometry::getSnapshot(){
+    return pose.read();
+}
+
+void Odometry::publish(const PoseSnapshot &snapshot){
+    pose.write(snapshot);
+    history.record(snapshot.pos, snapshot.timestamp);
+}
+
+bool Odometry::getPosAt(uint64_t timestamp, util::ChassisPos &pos){
+    return history.getPosAt(timestamp, pos);
+}
+
+OdometryStats Odometry::getStats(){
+    return stats.read();
+}
+
+WheelSlip Odometry::getSlip(){
+    return slip.read();
 }
 
-void Odometry::setChassisVel(util::ChassisSpeed speed){
-    localVel = speed;
+uint32_t Odometry::getReadRetries(){
+    return pose.getRetryCount();
 }
@@ -1,32 +1,227 @@
 #ifndef _ODOMETRY_HPP_INCLUDED
 #define _ODOMETRY_HPP_INCLUDED
 
+#include <atomic>
 #include "okapi/api.hpp"
+#include "pros/apix.h"
+#include "Eigen/Core"
 #include "subsystem.hpp"
 #include "util/struct.hpp"
+#include "util/seqlock.hpp"
+#include "util/math/velocityestimator.hpp"
+#include "systemmanager/posehistory.hpp"
+#include "systemmanager/odometrystep.hpp"
+#include "systemmanager/motorodometry.hpp"
+#include "systemmanager/slipdetector.hpp"
+#include "systemmanager/odometryrecorder.hpp"
+#include "systemmanager/poseekf.hpp"
+#include "systemmanager/relocalize.hpp"
+
+/// Everything the odometry task publishes in one cycle, read and written as a single unit.
+struct PoseSnapshot {
+    util::ChassisPos pos;   // x and y in inches, angle in radians
+    util::ChassisSpeed vel; // Chassis velocity, as a fraction of the max speed on each axis
+    // Filtered velocity and acceleration in inches and radians per second (squared).
+    // Field frame is along the field's x and y, robot frame is to the robot's right (x) and forward (y)
+    util::ChassisSpeed fieldVel, fieldAccel, robotVel, robotAccel;
+    uint64_t timestamp = 0; // util::micros() when the pose was calculated
+    // Uncertainty of x, y and angle from the EKF, in that order. All zeros when the filter is off
+    Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+    // Position from the drive motor encoders alone, to cross-check pos against. See MotorOdometry
+    util::ChassisPos motorPos;
+};
+
+/// How often the odometry task gets new sensor data, and how much of its work is spent on data it already had.
+struct OdometryStats {
+    uint32_t cycles;        // Times the sensors were read
+    uint32_t duplicates;    // Reads where no sensor had changed since the last one
+    uint32_t steps;         // Reads that were integrated. Lower than cycles when the loop skips duplicates
+    double encoderInterval; // Average time between tracking wheel changes while moving, in microseconds
+    double gyroInterval;    // Average time between heading sensor changes, in microseconds
+    uint32_t encoderAge;    // Time since the tracking wheels last changed, in microseconds
+    uint32_t gyroAge;       // Time since the heading sensor last changed, in microseconds
+    uint8_t unpluggedWheels; // TrackingWheel flags of the tracking wheels that stopped counting while the robot moved
+    bool motorFallback;      // True while the position comes from the drive motor encoders instead
+    double motorDivergence;  // Distance between the drive motor position and the published one, in inches
+};
+
+/// A change to odometry that the running odometry task applies at the start of its next cycle.
+struct OdometryCommand {
+    enum Type {
+        RESET,      // Move to pos, and zero the encoders if hardware is set
+        RELOCALIZE, // Correct the position from landmark, see field::relocalize()
+        CONFIGURE   // Pick up new heading source and filter settings, keeping the current position
+    };
+    Type type;
+    util::ChassisPos pos;            // RESET: the new position, angle in radians
+    bool hardware;                   // RESET: also zero the encoders
+    const field::Landmark *landmark; // RELOCALIZE: the landmark the robot is touching
+    double headingOffset;            // RELOCALIZE: radians added to the heading first
+    pros::task_t caller;             // Notified once the command is applied, NULL if nobody is waiting
+    uint32_t sequence;               // Numbers the command, so the caller knows when this one was applied
+};
 
 class Odometry {
 private:
     typedef okapi::ADIEncoder Enc;
     pros::task_t odoTask;
-    util::ChassisPos data;
-    util::ChassisSpeed localVel;
-    
+    util::SeqLock<PoseSnapshot> pose;
+    PoseHistory history;
+    /// Commands for the odometry task, so it never has to be stopped to change something.
+    pros::c::queue_t commands = NULL;
+    /// The sequence number of the last command queued, and of the last one the odometry task applied.
+    /// Commands are applied in order, so everything up to applied is done
+    std::atomic<uint32_t> queued{0}, applied{0};
+    /// Held while numbering and queueing a command, so the numbers are in queue order
+    pros::mutex_t sendMutex = NULL;
+    util::SeqLock<OdometryStats> stats;
+    util::SeqLock<WheelSlip> slip;
+
+    static void odometryTaskFn(void*);
+
+    /**
+     * Hands a command to the odometry task, or applies it right away if the task isn't running.
+     *
+     * \param command The command to apply.
+     *
+     * \param wait Blocks until the odometry task has applied the command if true.
+     *
+     * \return False if the command couldn't be queued or wasn't applied in time.
+     */
+    bool send(OdometryCommand command, bool wait);
+
+    /// Applies a command while the odometry task isn't running.
+    void applyDirectly(const OdometryCommand &command);
+
+    // The pose SeqLock only takes one writer. These are only called by the odometry task, or by applyDirectly while
+    // the task isn't running, so no other task can end up writing it at the same time. Move odometry with reset()
+
+    /// Replaces the position in the published snapshot, angle in radians.
+    void setPos(util::ChassisPos);
+
+    /**
+     * Publishes a full snapshot at once.
+     *
+     * \param snapshot The new position, velocity and timestamp.
+     */
+    void publish(const PoseSnapshot&);
+
 public:
+    enum LoopMode {
+        FIXED,        // Integrates every cycle, whether or not the sensors changed
+        ON_NEW_DATA,  // Polls every cycle, but only integrates when a sensor has changed
+        PHASE_LOCKED  // Like ON_NEW_DATA, and sleeps through the ADI update period after catching an update
+    };
+    /// Picked up on the next cycle.
+    LoopMode loopMode = ODOM_LOOP_MODE;
     int delay = 1;
     bool taskRunning = false;
     double zeroPosA;
     bool gyroRotation = true;
+    /// If true, the heading sources are fused with an EKF instead of using only the one picked by gyroRotation.
+    bool ekf = ODOM_USE_EKF;
+    /// How the velocity is filtered. Picked up the next time the odometry task starts.
+    util::VelocityEstimator::Filter velocityFilter = ODOM_VEL_FILTER;
+    /// If true, the drive motor encoders take over while a tracking wheel is unplugged. Picked up on the next cycle.
+    bool motorFallback = ODOM_MOTOR_FALLBACK;
     Odometry();
-    void useGyroRotation();
-    void useEncoderRotation();
-    void reset(util::ChassisPos, bool hardware = true);
+
+    /**
+     * Takes the heading from the gyro/IMU from now on. Takes effect within one odometry cycle.
+     *
+     * \param wait Blocks until the change is applied if true.
+     */
+    void useGyroRotation(bool wait = false);
+
+    /**
+     * Takes the heading from the side tracking wheels from now on. Takes effect within one odometry cycle.
+     *
+     * \param wait Blocks until the change is applied if true.
+     */
+    void useEncoderRotation(bool wait = false);
+
+    /**
+     * Turns the EKF on or off. Takes effect within one odometry cycle.
+     *
+     * \param enable True to fuse the IMU, tracking wheels and drive encoders, false to use a single heading source.
+     *
+     * \param wait Blocks until the change is applied if true.
+     */
+    void useEKF(bool enable, bool wait = false);
+
+    /**
+     * Moves odometry to a new position. The odometry task keeps running and applies it at the start of its next cycle.
+     *
+     * \param pos The new position, angle in degrees.
+     *
+     * \param hardware Also zeroes the tracking wheel and drive motor encoders if true.
+     *
+     * \param wait Blocks until the new position is in use if true, so getPos() returns it right after.
+     */
+    void reset(util::ChassisPos, bool hardware = true, bool wait = true);
     void startTask();
     void endTask();
     void resetForAuton();
     util::ChassisPos getPos();
     util::ChassisSpeed getChassisVel();
-    void setChassisVel(util::ChassisSpeed);
-    void setPos(util::ChassisPos);
+
+    /**
+     * Gets the position, velocity and timestamp from the same odometry cycle.
+     * Prefer this over calling getPos() and getChassisVel() separately when both are needed.
+     *
+     * \return The latest published snapshot.
+     */
+    PoseSnapshot getSnapshot();
+
+    /**
+     * Looks up where the robot was at a point in the recent past. Used to compensate for sensor latency.
+     *
+     * \param timestamp The time to look up, from util::micros().
+     *
+     * \param pos Filled with the interpolated pose, or the closest recorded pose if the time is out of range.
+     *
+     * \return True if the time is covered by the pose history (the last ODOM_HISTORY_SIZE cycles), false otherwise.
+     */
+    bool getPosAt(uint64_t timestamp, util::ChassisPos &pos);
+
+    /**
+     * Corrects the position from a landmark the robot is touching, like a goal it just scored in.
+     * The running odometry task applies the correction at the start of its next cycle instead of being restarted,
+     * so this returns within a couple of milliseconds.
+     *
+     * \param landmark The landmark the robot is touching, from the field namespace.
+     *
+     * \param headingOffset Degrees added to the current heading before relocalizing against a goal.
+     *
+     * \return The corrected position, angle in radians.
+     */
+    util::ChassisPos relocalizeAgainst(const field::Landmark &landmark, double headingOffset = 0);
+
+    /// Records the raw sensor stream while odometry runs. Replay it off the robot with tools/odomreplay.cpp
+    OdometryRecorder recorder;
+
+    /**
+     * Starts recording the raw odometry sensor stream to the SD card.
+     *
+     * \param filename Where to save the recording.
+     *
+     * \return True if the recording was started, false if the file couldn't be opened.
+     */
+    bool startRecording(const char *filename = ODOM_RECORD_FILE);
+
+    /// Finishes writing the recording to the SD card.
+    void stopRecording();
+
+    /// \return The chassis constants and modes odometry is currently running with.
+    OdometryConfig getConfig();
+
+    /// \return Duplicate sample counts and sensor freshness from the odometry task.
+    OdometryStats getStats();
+
+    /// \return How much each drive wheel slips compared to the tracking wheels, updated whenever the motors are read.
+    WheelSlip getSlip();
+
+    /// \return How many times a read had to be retried because the odometry task was writing at the same time.
+    uint32_t getReadRetries();
 };
 #endif /* _ODOMETRY_HPP_INCLUDED */
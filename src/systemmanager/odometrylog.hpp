@@ -0,0 +1,52 @@
+// Binary format of odometry recordings. Shared between the recorder on the robot and tools/odomreplay.cpp
+//
+// A recording is one OdometryLogHeader followed by any number of OdometryLogRecords.
+// Everything is little endian, which is what both the V5 and any PC we use are.
+
+#ifndef _ODOMETRYLOG_HPP_INCLUDED
+#define _ODOMETRYLOG_HPP_INCLUDED
+
+#include <cstdint>
+
+#define ODOMETRY_LOG_MAGIC 0x4D4F444F // "ODOM"
+#define ODOMETRY_LOG_VERSION 2 // UPDATE THIS VALUE ON BREAKING CHANGE TO THE FORMAT
+
+struct OdometryLogHeader {
+    uint32_t magic;
+    uint32_t version;
+    // Chassis constants the recording was made with, so replays start from the same numbers
+    float leftEncToIn;
+    float rightEncToIn;
+    float backEncToIn;
+    float chassisWidth;
+    float backToCenter;
+};
+
+struct OdometryLogRecord {
+    enum Type : uint16_t {
+        SAMPLE = 0, // A set of sensor readings
+        START = 1   // The odometry task (re)started from a known position
+    };
+    enum Flags : uint16_t {
+        GYRO_ROTATION = 0b01,
+        RED_SIDE = 0b10
+    };
+
+    uint16_t type;
+    uint16_t flags; // Only used by START records
+    uint32_t time;  // Microseconds since the recording started
+    union {
+        struct {
+            int32_t left, right, back; // Raw tracking wheel ticks
+            float gyro;                // Degrees
+        } sample;
+        struct {
+            float x, y, angle; // Starting position, angle in radians
+            float zeroPosA;    // Heading offset in radians
+        } start;
+    };
+};
+
+static_assert(sizeof(OdometryLogHeader) == 28, "odometry log header layout changed");
+static_assert(sizeof(OdometryLogRecord) == 24, "odometry log record layout changed");
+#endif /* _ODOMETRYLOG_HPP_INCLUDED */
@@ -0,0 +1,143 @@
+#include "odometryrecorder.hpp"
+
+#include <cmath>
+#include "io.hpp"
+#include "util/util.hpp"
+
+void OdometryRecorder::writerTaskFn(void *param) {
+    OdometryRecorder *recorder = (OdometryRecorder *)param;
+    while (true) {
+        pros::c::task_notify_take(true, TIMEOUT_MAX);
+        int full = recorder->fullBuffer.load();
+        if (full >= 0) {
+            fwrite(recorder->buffers[full], sizeof(OdometryLogRecord), ODOM_RECORD_BUFFER, recorder->file);
+            recorder->fullBuffer.store(-1);
+        }
+
+        // Closing the file here means nothing else ever touches it while a write is in progress
+        if (recorder->stopping.load()) {
+            fwrite(recorder->buffers[recorder->activeBuffer], sizeof(OdometryLogRecord), recorder->fill, recorder->file);
+            fclose(recorder->file);
+            recorder->file = NULL;
+            recorder->writerRunning.store(false);
+            pros::c::task_delete(NULL);
+        }
+    }
+}
+
+bool OdometryRecorder::start(const char *filename, const OdometryConfig &config) {
+    if (isRecording())
+        stop();
+    if (writerRunning.load()) {
+        localStorage.log("Odometry recorder is still writing the last recording");
+        return false;
+    }
+    if (!pros::usd::is_installed())
+        return false;
+    file = fopen(filename, "wb");
+    if (file == NULL)
+        return false;
+
+    OdometryLogHeader header = {ODOMETRY_LOG_MAGIC, ODOMETRY_LOG_VERSION, (float)config.leftEncToIn,
+                                (float)config.rightEncToIn, (float)config.backEncToIn, (float)config.chassisWidth,
+                                (float)config.backToCenter};
+    fwrite(&header, sizeof(header), 1, file);
+
+    activeBuffer = 0;
+    fill = 0;
+    dropped = 0;
+    fullBuffer.store(-1);
+    stopping.store(false);
+    writerRunning.store(true);
+    startTime = util::micros();
+    writerTask = pros::c::task_create(writerTaskFn, this, TASK_PRIORITY_MIN, TASK_STACK_DEPTH_DEFAULT,
+                                      "Odometry recorder task");
+    startPending.store(true);
+    recording.store(true);
+    return true;
+}
+
+void OdometryRecorder::stop() {
+    if (!recording.exchange(false))
+        return;
+    // The odometry task sets pushing before it checks recording, so from here on it either saw the recording
+    // stopped or is still adding a record, which it finishes before anything is written out
+    while (pushing.load())
+        pros::delay(1);
+
+    // The writer task finishes the buffer it may be in the middle of, then writes the rest and closes the file.
+    // It's never deleted from here, as that could stop it half way through a write and leave the card locked
+    stopping.store(true);
+    pros::c::task_notify(writerTask);
+    if (!util::blocking([&] { return !writerRunning.load(); }, 500, 5))
+        localStorage.log("Odometry recorder flush timed out, the file is closed once the SD card catches up");
+
+    if (dropped > 0) {
+        char logBuf[60];
+        sprintf(logBuf, "Odometry recorder dropped %lu records", (long unsigned int)dropped);
+        localStorage.log(logBuf);
+    }
+}
+
+bool OdometryRecorder::isRecording() {
+    return recording.load();
+}
+
+bool OdometryRecorder::isStartPending() {
+    return recording.load() && startPending.load();
+}
+
+void OdometryRecorder::push(const OdometryLogRecord &record) {
+    buffers[activeBuffer][fill++] = record;
+    if (fill < ODOM_RECORD_BUFFER)
+        return;
+
+    if (fullBuffer.load() >= 0) {
+        // The SD card is still busy with the other buffer. Throw this one away instead of blocking odometry
+        dropped += fill;
+    } else {
+        fullBuffer.store(activeBuffer);
+        activeBuffer ^= 1;
+        pros::c::task_notify(writerTask);
+    }
+    fill = 0;
+}
+
+void OdometryRecorder::recordStart(const OdometryState &state, const OdometryConfig &config, uint64_t timestamp) {
+    pushing.store(true);
+    if (!recording.load()) {
+        pushing.store(false);
+        return;
+    }
+    OdometryLogRecord record;
+    record.type = OdometryLogRecord::START;
+    record.flags = (config.gyroRotation ? OdometryLogRecord::GYRO_ROTATION : 0) |
+                   (config.redSide ? OdometryLogRecord::RED_SIDE : 0);
+    record.time = timestamp - startTime;
+    // Folding the gyro wraps into the offset lets the replay start with the same heading the robot had
+    record.start = {(float)state.x, (float)state.y, (float)state.angle,
+                    (float)(state.zeroPosA - state.gyroCounter * 2 * M_PI)};
+    push(record);
+    startPending.store(false);
+    pushing.store(false);
+}
+
+void OdometryRecorder::recordSample(const OdometrySample &sample) {
+    pushing.store(true);
+    if (!recording.load()) {
+        pushing.store(false);
+        return;
+    }
+    OdometryLogRecord record;
+    record.type = OdometryLogRecord::SAMPLE;
+    record.flags = 0;
+    record.time = sample.timestamp - startTime;
+    record.sample = {(int32_t)std::lround(sample.left), (int32_t)std::lround(sample.right),
+                     (int32_t)std::lround(sample.back), (float)sample.gyro};
+    push(record);
+    pushing.store(false);
+}
+
+uint32_t OdometryRecorder::getDroppedCount() {
+    return dropped;
+}
@@ -0,0 +1,87 @@
+#ifndef _ODOMETRYRECORDER_HPP_INCLUDED
+#define _ODOMETRYRECORDER_HPP_INCLUDED
+
+#include <atomic>
+#include <cstdio>
+#include "api.h"
+#include "systemmanager/odometrystep.hpp"
+#include "systemmanager/odometrylog.hpp"
+
+// Number of records buffered in memory before they are handed to the SD card writer task
+#define ODOM_RECORD_BUFFER 256
+
+/**
+ * Records the raw odometry sensor stream to the SD card, so it can be replayed off the robot with tools/odomreplay.cpp
+ *
+ * Records are collected into one of two buffers by the odometry task. When a buffer fills up, a separate low
+ * priority task writes it out while the odometry task keeps filling the other one, so the odometry loop never
+ * waits on the SD card.
+ */
+class OdometryRecorder {
+private:
+    FILE *file = NULL;
+    pros::task_t writerTask;
+    OdometryLogRecord buffers[2][ODOM_RECORD_BUFFER];
+    int activeBuffer = 0, fill = 0;
+    /// Index of the buffer waiting to be written, or -1 if the writer task is idle.
+    std::atomic<int> fullBuffer{-1};
+    std::atomic<bool> recording{false};
+    /// Set until the first START record of a recording has been written.
+    std::atomic<bool> startPending{false};
+    /// Set by stop(). The writer task then writes what's left, closes the file and exits on its own
+    std::atomic<bool> stopping{false};
+    /// True from start() until the writer task has closed the file
+    std::atomic<bool> writerRunning{false};
+    /// True while the odometry task is adding a record. stop() waits for it to clear before touching the buffers
+    std::atomic<bool> pushing{false};
+    uint64_t startTime = 0;
+    uint32_t dropped = 0;
+
+    static void writerTaskFn(void*);
+    void push(const OdometryLogRecord&);
+
+public:
+    /**
+     * Opens a new recording on the SD card, replacing any file with the same name.
+     *
+     * \param filename Where to save the recording.
+     *
+     * \param config The chassis constants to save in the recording's header.
+     *
+     * \return True if the file was opened, false if there is no SD card, the file couldn't be created
+     * or the last recording is still being written out.
+     */
+    bool start(const char *filename, const OdometryConfig &config);
+
+    /**
+     * Has the writer task write out everything that's left in the buffers and close the recording.
+     * Waits up to half a second for it. If the SD card is slower than that, the writer finishes on its own
+     * and a new recording can't start until it has.
+     */
+    void stop();
+
+    /// \return True if a recording is open.
+    bool isRecording();
+
+    /// \return True if the recording was just opened and still needs a START record before any samples.
+    bool isStartPending();
+
+    /**
+     * Records that odometry (re)started from a known position. Should only be called by the odometry task.
+     * The next sample recorded is the one the replay initializes from.
+     *
+     * \param state The odometry state right after initializing it.
+     *
+     * \param config The modes odometry is running in.
+     *
+     * \param timestamp When odometry started, from util::micros().
+     */
+    void recordStart(const OdometryState &state, const OdometryConfig &config, uint64_t timestamp);
+
+    /// Records a set of sensor readings. Should only be called by the odometry task.
+    void recordSample(const OdometrySample &sample);
+
+    /// \return The number of records thrown away because the SD card couldn't keep up.
+    uint32_t getDroppedCount();
+};
+#endif /* _ODOMETRYRECORDER_HPP_INCLUDED */
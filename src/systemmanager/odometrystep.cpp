@@ -0,0 +1,136 @@
+#include "odometrystep.hpp"
+
+/*
+x: ⬅️ negative, ➡️ positive
+y: ⬇️ negative, ⬆️ positive
+a: ↩️ positive, ↪️ negative
+*/
+
+namespace {
+    inline double degToRad(double degrees) {
+        return degrees * M_PI / 180.0;
+    }
+
+    // The heading the sensors are currently reporting, before applying the red/blue mirroring
+    double sensorHeading(OdometryState &state, const OdometrySample &sample, const OdometryConfig &config) {
+        if (config.gyroRotation) {
+            // The gyro wraps around at ±180 degrees, but we don't want the heading to jump by a full rotation
+            // We detect when this happens and make the rotation continuous by counting the wraps
+            if (sample.gyro - state.lastGyro > 180)
+                state.gyroCounter--;
+            else if (sample.gyro - state.lastGyro < -180)
+                state.gyroCounter++;
+            state.lastGyro = sample.gyro;
+            return degToRad(state.gyroCounter * 360 + sample.gyro) - state.zeroPosA;
+        }
+        return (sample.left * config.leftEncToIn - sample.right * config.rightEncToIn) / config.chassisWidth - state.zeroPosA;
+    }
+}
+
+void initOdometry(OdometryState &state, const OdometrySample &sample, const OdometryConfig &config,
+                  util::ChassisPos start, double zeroPosA) {
+    state.x = start.x;
+    state.y = start.y;
+    state.angle = start.angle;
+    state.zeroPosA = zeroPosA;
+    state.lastL = sample.left;
+    state.lastR = sample.right;
+    state.lastB = sample.back;
+    state.lastGyro = sample.gyro;
+    state.gyroCounter = 0;
+    state.lastMove = {0, 0, 0};
+    state.lastTwist = {0, 0, 0};
+    if (config.gyroRotation) {
+        state.lastA = degToRad(sample.gyro) - zeroPosA;
+    } else {
+        // Tracking wheel ticks are relative, so line them up with the starting heading
+        state.lastA = start.angle * (config.redSide ? 1.0 : -1.0);
+        state.zeroPosA = (sample.left * config.leftEncToIn - sample.right * config.rightEncToIn) / config.chassisWidth -
+                         state.lastA;
+    }
+}
+
+void ArcIntegrator::integrate(double dL, double dR, double dB, double dA, const OdometryConfig &config,
+                              double &dX, double &dY) {
+    // http://thepilons.ca/wp-content/uploads/2018/10/Tracking.pdf
+    if (dA == 0) {
+        dX = dB;
+        dY = (dL + dR) / 2.0;
+    } else {
+        double r = dR / dA;
+        double r2 = dB / dA;
+        double sinI = std::sin(dA / 2.0);
+        dX = 2 * sinI * (r2 + config.backToCenter);
+        dY = 2 * sinI * (r + config.chassisWidth / 2.0);
+    }
+}
+
+void ExpMapIntegrator::integrate(double dL, double dR, double dB, double dA, const OdometryConfig &config,
+                                 double &dX, double &dY) {
+    // Arc lengths travelled by the tracking center
+    double forward = (dL + dR) / 2.0;
+    double sideways = dB + dA * config.backToCenter;
+
+    // Chord of a constant curvature arc is sin(dA/2)/(dA/2) times the arc length, along the average heading.
+    // Taylor series near zero so tiny rotations don't divide by almost nothing
+    double half = dA / 2.0;
+    double chord = std::fabs(half) < 1e-4 ? 1 - half * half / 6.0 : std::sin(half) / half;
+    dX = sideways * chord;
+    dY = forward * chord;
+}
+
+void MidpointIntegrator::integrate(double dL, double dR, double dB, double dA, const OdometryConfig &config,
+                                   double &dX, double &dY) {
+    // Straight line at the average heading, RK2 style. Ignores the arc, which is off by about dA²/24
+    dX = dB + dA * config.backToCenter;
+    dY = (dL + dR) / 2.0;
+}
+
+template <typename Integrator>
+bool stepOdometry(OdometryState &state, const OdometrySample &sample, const OdometryConfig &config) {
+    //Calculating the amount each tracking wheel as moved, in inches
+    double dL = (sample.left - state.lastL) * config.leftEncToIn; // amount left side moved
+    double dR = (sample.right - state.lastR) * config.rightEncToIn; // amount right side moved
+    double dB = (sample.back - state.lastB) * config.backEncToIn; // amount back tracking wheel moved
+
+    state.lastL = sample.left;
+    state.lastR = sample.right;
+    state.lastB = sample.back;
+
+    // If moving unreasonably fast, just ignore the inputs.
+    // This might happen at the start of the program, or when the encoders somehow gets reset
+    if (std::fabs(dL) > 1 || std::fabs(dR) > 1 || std::fabs(dB) > 1)
+        return false;
+
+    //Finding the new heading and difference in heading
+    double newA = sensorHeading(state, sample, config);
+    double dA = newA - state.lastA;
+
+    double dX, dY;
+    Integrator::integrate(dL, dR, dB, dA, config, dX, dY);
+
+    double mA = state.lastA + dA / 2.0; // the angle between the last angle and the current angle,
+                                        // assumed to be the direction the robot moved in
+
+    double cosMA = std::cos(mA);
+    double sinMA = std::sin(mA);
+
+    // Update the global position
+    if (config.redSide) {
+        state.angle = newA;
+        state.x += (dY * sinMA) + (dX * cosMA);
+    } else {
+        state.angle = -newA;
+        state.x -= (dY * sinMA) + (dX * cosMA);
+    }
+    state.y += (dY * cosMA) + (dX * -sinMA);
+
+    state.lastMove = {dB, (dL + dR) / 2.0, dA};
+    state.lastTwist = {config.redSide ? dX : -dX, dY, config.redSide ? dA : -dA};
+    state.lastA = newA;
+    return true;
+}
+
+template bool stepOdometry<ArcIntegrator>(OdometryState&, const OdometrySample&, const OdometryConfig&);
+template bool stepOdometry<ExpMapIntegrator>(OdometryState&, const OdometrySample&, const OdometryConfig&);
+template bool stepOdometry<MidpointIntegrator>(OdometryState&, const OdometrySample&, const OdometryConfig&);
@@ -0,0 +1,111 @@
+// The odometry math, kept free of any PROS calls so it can also be compiled and run off the robot
+// (see tools/odomreplay.cpp)
+
+#ifndef _ODOMETRYSTEP_HPP_INCLUDED
+#define _ODOMETRYSTEP_HPP_INCLUDED
+
+#include <cmath>
+#include <cstdint>
+#include "profiles.hpp"
+#include "util/struct.hpp"
+
+/// One reading of every sensor odometry uses.
+struct OdometrySample {
+    uint64_t timestamp; // Microseconds
+    double left;        // Left tracking wheel, raw encoder ticks
+    double right;       // Right tracking wheel, raw encoder ticks
+    double back;        // Back tracking wheel, raw encoder ticks
+    double gyro;        // Heading sensor in degrees, wrapped to ±180
+};
+
+/// Chassis constants and modes that the odometry math depends on.
+struct OdometryConfig {
+    double leftEncToIn = SIDE_ENC_TO_IN;
+    double rightEncToIn = SIDE_ENC_TO_IN;
+    double backEncToIn = BACK_ENC_TO_IN;
+    double chassisWidth = ENC_BASE_WIDTH_IN;
+    double backToCenter = BACK_TO_CENTER_IN;
+    bool gyroRotation = true; // Heading from the gyro/IMU if true, from the side tracking wheels otherwise
+    bool redSide = true;      // The field is mirrored on the blue side
+};
+
+/// Everything odometry carries over from one step to the next.
+struct OdometryState {
+    // Global position, x and y in inches, angle in radians
+    double x = 0, y = 0, angle = 0;
+    // Heading offset between the sensor and the field, in radians
+    double zeroPosA = 0;
+
+    // Sensor values from the last step
+    double lastL = 0, lastR = 0, lastB = 0;
+    double lastA = 0, lastGyro = 0;
+    // Number of times the heading sensor has wrapped around
+    int gyroCounter = 0;
+
+    // How much the robot moved during the last step, relative to the robot.
+    // x (back wheel) and y (average of side wheels) in inches, angle in radians
+    util::ChassisSpeed lastMove = {0, 0, 0};
+
+    // The last step as a twist in the robot's frame, after the arc correction and the red/blue mirroring.
+    // The field position moved by x to the robot's right and y forward, at a heading halfway between the old and new one
+    util::ChassisSpeed lastTwist = {0, 0, 0};
+};
+
+/*
+ * Integrators turn the tracking wheel movement of one step into the robot's movement, in the frame of the
+ * average heading between the start and end of the step (x to the right, y forward).
+ * They are picked at compile time with the template parameter of stepOdometry so there's no virtual call in the loop.
+ */
+
+/// The single arc method from the Pilons tracking paper. Falls back to a straight line when the heading didn't change.
+struct ArcIntegrator {
+    static void integrate(double dL, double dR, double dB, double dA, const OdometryConfig &config, double &dX, double &dY);
+};
+
+/**
+ * Exact SE(2) exponential map of the step's twist, assuming constant velocity and turn rate during the step.
+ * Uses the average of both side wheels and stays continuous as the rotation goes to zero.
+ */
+struct ExpMapIntegrator {
+    static void integrate(double dL, double dR, double dB, double dA, const OdometryConfig &config, double &dX, double &dY);
+};
+
+/// Midpoint (RK2) integration. A straight line at the average heading, cheapest but ignores the arc.
+struct MidpointIntegrator {
+    static void integrate(double dL, double dR, double dB, double dA, const OdometryConfig &config, double &dX, double &dY);
+};
+
+/**
+ * Sets up the odometry state to continue from a known position.
+ *
+ * \param state The state to initialize.
+ *
+ * \param sample The sensor values at the starting position.
+ *
+ * \param config The chassis constants and modes to use.
+ *
+ * \param start The starting position, angle in radians.
+ *
+ * \param zeroPosA The heading offset between the gyro and the field, in radians.
+ * Only used when the heading comes from the gyro. The tracking wheel heading always continues from start.angle.
+ */
+void initOdometry(OdometryState &state, const OdometrySample &sample, const OdometryConfig &config,
+                  util::ChassisPos start, double zeroPosA);
+
+/**
+ * Integrates one new set of sensor values into the position.
+ *
+ * \param state The state from the previous step. Updated in place.
+ *
+ * \param sample The new sensor values.
+ *
+ * \param config The chassis constants and modes to use.
+ *
+ * \tparam Integrator How the wheel movement is integrated. ArcIntegrator, ExpMapIntegrator or MidpointIntegrator.
+ *
+ * \return True if the position was updated,
+ * false if the sample was thrown away because the tracking wheels jumped unreasonably far.
+ */
+template <typename Integrator = ODOM_INTEGRATOR>
+bool stepOdometry(OdometryState &state, const OdometrySample &sample, const OdometryConfig &config);
+#endif /* _ODOMETRYSTEP_HPP_INCLUDED */
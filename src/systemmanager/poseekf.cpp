@@ -0,0 +1,82 @@
+#include "poseekf.hpp"
+
+#include <cmath>
+#include "profiles.hpp"
+
+PoseEKF::PoseEKF() {
+    reset({0, 0, 0});
+}
+
+void PoseEKF::reset(util::ChassisPos pos, double positionVariance, double headingVariance) {
+    state << pos.x, pos.y, pos.angle;
+    covariance.setZero();
+    covariance(0, 0) = covariance(1, 1) = positionVariance;
+    covariance(2, 2) = headingVariance;
+    stepTurn = 0;
+    stepNoise.setZero();
+}
+
+void PoseEKF::predict(const util::ChassisSpeed &twist) {
+    // Same motion model as odometry: move along the average heading of the step
+    double midAngle = state(2) + twist.angle / 2.0;
+    double c = std::cos(midAngle), s = std::sin(midAngle);
+    double dX = twist.y * s + twist.x * c;
+    double dY = twist.y * c - twist.x * s;
+
+    state(0) += dX;
+    state(1) += dY;
+    state(2) += twist.angle;
+
+    // Jacobian of the motion with respect to the state. Only the heading changes where the robot ends up
+    Eigen::Matrix3d F = Eigen::Matrix3d::Identity();
+    F(0, 2) = dY;
+    F(1, 2) = -dX;
+
+    // Jacobian with respect to the measured movement, so the wheel noise lands in field coordinates
+    Eigen::Matrix3d G;
+    G << c, s, dY / 2.0,
+        -s, c, -dX / 2.0,
+         0, 0, 1;
+
+    // Tracking wheel error grows with how far they roll, plus some slip on every step
+    double distance = std::fabs(twist.x) + std::fabs(twist.y);
+    Eigen::Vector3d noise(EKF_TRANSLATION_NOISE * std::fabs(twist.x) + EKF_STEP_NOISE,
+                          EKF_TRANSLATION_NOISE * std::fabs(twist.y) + EKF_STEP_NOISE,
+                          EKF_ROTATION_NOISE * (std::fabs(twist.angle) + distance / ENC_BASE_WIDTH_IN) + EKF_STEP_NOISE);
+
+    stepTurn = twist.angle;
+    stepNoise = G * noise.asDiagonal() * G.transpose();
+    covariance = F * covariance * F.transpose() + stepNoise;
+}
+
+void PoseEKF::updateHeading(double heading, double variance) {
+    // H = [0 0 1], so the gain only needs the last column of the covariance
+    double innovationVariance = covariance(2, 2) + variance;
+    Eigen::Vector3d gain = covariance.col(2) / innovationVariance;
+
+    state += gain * (heading - state(2));
+    covariance -= gain * covariance.row(2);
+    // The step's noise is no longer separate from the rest of the covariance, so a yaw rate can't be fused after this
+    stepNoise.setZero();
+}
+
+void PoseEKF::updateYawRate(double rate, double dt, double variance) {
+    // The rate measures how far the last step turned. That step's error is only the noise predict added, which
+    // doesn't depend on anything before it, so the gain comes from that noise instead of the whole covariance
+    double innovationVariance = stepNoise(2, 2) + variance * dt * dt;
+    if (innovationVariance <= 0)
+        return;
+    Eigen::Vector3d gain = stepNoise.col(2) / innovationVariance;
+
+    state += gain * (rate * dt - stepTurn);
+    covariance -= gain * stepNoise.row(2);
+    stepNoise.setZero();
+}
+
+util::ChassisPos PoseEKF::getPos() {
+    return {state(0), state(1), state(2)};
+}
+
+Eigen::Matrix3d PoseEKF::getCovariance() {
+    return covariance;
+}
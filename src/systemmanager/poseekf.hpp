@@ -0,0 +1,73 @@
+#ifndef _POSEEKF_HPP_INCLUDED
+#define _POSEEKF_HPP_INCLUDED
+
+#include "Eigen/Core"
+#include "util/struct.hpp"
+
+/**
+ * Extended Kalman filter for the robot's field position.
+ *
+ * The state is x, y (inches) and heading (radians), same as util::ChassisPos.
+ * Tracking wheel movement drives the prediction step, and any absolute heading source (IMU, drive motor encoders)
+ * can be fused in as a measurement, as can the IMU's yaw rate. Everything is fixed size, so nothing is allocated
+ * while running.
+ *
+ * Kept free of PROS calls so it can run off the robot as well.
+ */
+class PoseEKF {
+private:
+    Eigen::Vector3d state;
+    Eigen::Matrix3d covariance;
+    // Turn and noise added by the last predict, for the yaw rate to correct. Noise is zero once it has been fused
+    double stepTurn;
+    Eigen::Matrix3d stepNoise;
+
+public:
+    PoseEKF();
+
+    /**
+     * Restarts the filter from a known position.
+     *
+     * \param pos The starting position, angle in radians.
+     *
+     * \param positionVariance How uncertain the starting x and y are, in square inches.
+     *
+     * \param headingVariance How uncertain the starting heading is, in square radians.
+     */
+    void reset(util::ChassisPos pos, double positionVariance = 0, double headingVariance = 0);
+
+    /**
+     * Moves the estimate by one odometry step. The uncertainty grows with the distance and angle moved.
+     *
+     * \param twist The robot relative movement from OdometryState::lastTwist.
+     */
+    void predict(const util::ChassisSpeed &twist);
+
+    /**
+     * Corrects the estimate with an absolute heading measurement.
+     *
+     * \param heading The measured field heading in radians. Must be unwrapped the same way as the filter's heading.
+     *
+     * \param variance How much the measurement is trusted, in square radians. Smaller is trusted more.
+     */
+    void updateHeading(double heading, double variance);
+
+    /**
+     * Corrects the turn of the last predict with a yaw rate measurement. Call right after predict: a heading update
+     * in between, or an earlier call, leaves nothing to correct until the next predict.
+     *
+     * \param rate The measured turn rate in radians per second, clockwise positive like the heading.
+     *
+     * \param dt How long the last predict's movement took, in seconds.
+     *
+     * \param variance How much the rate is trusted, in square radians per second squared.
+     */
+    void updateYawRate(double rate, double dt, double variance);
+
+    /// \return The current estimate of the position.
+    util::ChassisPos getPos();
+
+    /// \return The covariance of x, y and heading, in that order.
+    Eigen::Matrix3d getCovariance();
+};
+#endif /* _POSEEKF_HPP_INCLUDED */
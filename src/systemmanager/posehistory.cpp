@@ -0,0 +1,103 @@
+#include "posehistory.hpp"
+
+#include <cmath>
+
+namespace {
+    /**
+     * Interpolates between two poses along the constant twist (arc) that connects them.
+     * Our heading is measured clockwise from +y, so x and y are swapped to do the math in the usual
+     * counter clockwise frame. Swapping axes is a mirror, which keeps arcs as arcs.
+     */
+    util::ChassisPos interpolateSE2(util::ChassisPos a, util::ChassisPos b, double t) {
+        double dTheta = b.angle - a.angle;
+        double c = std::cos(a.angle), s = std::sin(a.angle);
+        // World displacement, converted to the frame of the first pose
+        double worldX = b.y - a.y, worldY = b.x - a.x;
+        double localX = c * worldX + s * worldY;
+        double localY = -s * worldX + c * worldY;
+
+        // Undo the arc to get the twist that moves a to b in one unit of time
+        double A = 1, B = 0;
+        if (std::fabs(dTheta) > 1e-9) {
+            A = std::sin(dTheta) / dTheta;
+            B = (1 - std::cos(dTheta)) / dTheta;
+        }
+        double det = A * A + B * B;
+        double vX = (A * localX + B * localY) / det;
+        double vY = (-B * localX + A * localY) / det;
+
+        // Follow the same twist for a fraction of the time
+        double partTheta = dTheta * t;
+        A = 1, B = 0;
+        if (std::fabs(partTheta) > 1e-9) {
+            A = std::sin(partTheta) / partTheta;
+            B = (1 - std::cos(partTheta)) / partTheta;
+        }
+        double partX = (A * vX - B * vY) * t;
+        double partY = (B * vX + A * vY) * t;
+
+        return {a.x + s * partX + c * partY, a.y + c * partX - s * partY, a.angle + partTheta};
+    }
+}
+
+void PoseHistory::record(const util::ChassisPos &pos, uint64_t timestamp) {
+    uint32_t n = count.load(std::memory_order_relaxed);
+    Entry &entry = at(n);
+    entry.timestamp = timestamp;
+    entry.x = pos.x;
+    entry.y = pos.y;
+    entry.angle = pos.angle;
+    count.store(n + 1, std::memory_order_release);
+}
+
+bool PoseHistory::getPosAt(uint64_t timestamp, util::ChassisPos &pos) {
+    while (true) {
+        uint32_t n = count.load(std::memory_order_acquire);
+        if (n == 0)
+            return false;
+
+        // The slot after the newest one might be getting overwritten right now, so it is never read
+        uint32_t oldest = n > ODOM_HISTORY_SIZE - 1 ? n - (ODOM_HISTORY_SIZE - 1) : 0;
+        uint32_t newest = n - 1;
+
+        Entry first = at(oldest), last = at(newest), before, after;
+        bool covered = true;
+        if (timestamp <= first.timestamp) {
+            before = after = first;
+            covered = timestamp == first.timestamp;
+        } else if (timestamp >= last.timestamp) {
+            before = after = last;
+            covered = timestamp == last.timestamp;
+        } else {
+            // Binary search for the last entry at or before the timestamp
+            uint32_t lo = oldest, hi = newest;
+            while (hi - lo > 1) {
+                uint32_t mid = lo + (hi - lo) / 2;
+                if (at(mid).timestamp <= timestamp)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            before = at(lo);
+            after = at(hi);
+        }
+
+        // If the writer lapped the part of the buffer we read from, the entries could be torn. Try again.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (count.load(std::memory_order_relaxed) - oldest >= ODOM_HISTORY_SIZE)
+            continue;
+
+        util::ChassisPos a = {before.x, before.y, before.angle};
+        if (after.timestamp == before.timestamp) {
+            pos = a;
+        } else {
+            util::ChassisPos b = {after.x, after.y, after.angle};
+            pos = interpolateSE2(a, b, (double)(timestamp - before.timestamp) / (after.timestamp - before.timestamp));
+        }
+        return covered;
+    }
+}
+
+void PoseHistory::clear() {
+    count.store(0, std::memory_order_release);
+}
@@ -0,0 +1,57 @@
+#ifndef _POSEHISTORY_HPP_INCLUDED
+#define _POSEHISTORY_HPP_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include "profiles.hpp"
+#include "util/struct.hpp"
+
+/**
+ * Fixed size ring buffer of timestamped poses.
+ * Lets us look up where the robot was when a late sensor reading (vision, indexer) was actually taken.
+ *
+ * Only one task may record into it. Any number of tasks can look poses up at the same time.
+ */
+class PoseHistory {
+private:
+    struct Entry {
+        uint64_t timestamp;
+        double x;
+        double y;
+        double angle;
+    };
+
+    Entry entries[ODOM_HISTORY_SIZE];
+
+    /// Total number of poses ever recorded. The newest pose is at (count - 1) % ODOM_HISTORY_SIZE.
+    std::atomic<uint32_t> count{0};
+
+    Entry &at(uint32_t index) { return entries[index % ODOM_HISTORY_SIZE]; }
+
+public:
+    /**
+     * Adds a pose to the history, overwriting the oldest one if the buffer is full.
+     * Timestamps must be increasing.
+     *
+     * \param pos The pose to record.
+     *
+     * \param timestamp The time the pose was calculated at, from util::micros().
+     */
+    void record(const util::ChassisPos &pos, uint64_t timestamp);
+
+    /**
+     * Finds the pose of the robot at a point in time, interpolating between the two closest records.
+     * Interpolation assumes the robot moved along a constant curvature arc between the two records.
+     *
+     * \param timestamp The time to look up, from util::micros().
+     *
+     * \param pos Filled with the pose at that time. If the time is outside of the history, the closest pose is used.
+     *
+     * \return True if the timestamp was covered by the history, false otherwise.
+     */
+    bool getPosAt(uint64_t timestamp, util::ChassisPos &pos);
+
+    /// Forgets every recorded pose.
+    void clear();
+};
+#endif /* _POSEHISTORY_HPP_INCLUDED */
@@ -0,0 +1,43 @@
+#include "relocalize.hpp"
+
+#include <cmath>
+#include "profiles.hpp"
+
+namespace field {
+    // Goals sit GOAL_INSET_IN off the walls they are against
+    const Landmark bottomLeftGoal = {Landmark::GOAL, "bottom left goal", -144 + GOAL_INSET_IN, GOAL_INSET_IN, 0};
+    const Landmark bottomMiddleGoal = {Landmark::GOAL, "bottom middle goal", -72, GOAL_INSET_IN, 0};
+    const Landmark bottomRightGoal = {Landmark::GOAL, "bottom right goal", -GOAL_INSET_IN, GOAL_INSET_IN, 0};
+    const Landmark middleLeftGoal = {Landmark::GOAL, "middle left goal", -144 + GOAL_INSET_IN, 72, 0};
+    const Landmark centerGoal = {Landmark::GOAL, "center goal", -72, 72, 0};
+    const Landmark middleRightGoal = {Landmark::GOAL, "middle right goal", -GOAL_INSET_IN, 72, 0};
+    // The skills run was tuned with this goal 2 inches further in on both axes than the others, so it stays there
+    const Landmark topLeftGoal = {Landmark::GOAL, "top left goal", -142 + GOAL_INSET_IN, 142 - GOAL_INSET_IN, 0};
+    const Landmark topMiddleGoal = {Landmark::GOAL, "top middle goal", -72, 144 - GOAL_INSET_IN, 0};
+    const Landmark topRightGoal = {Landmark::GOAL, "top right goal", -GOAL_INSET_IN, 144 - GOAL_INSET_IN, 0};
+
+    // A robot backed into a wall faces straight away from it
+    const Landmark leftWall = {Landmark::WALL, "left wall", -144, 72, M_PI / 2};
+    const Landmark rightWall = {Landmark::WALL, "right wall", 0, 72, -M_PI / 2};
+    const Landmark bottomWall = {Landmark::WALL, "bottom wall", -72, 0, 0};
+    const Landmark topWall = {Landmark::WALL, "top wall", -72, 144, M_PI};
+
+    util::ChassisPos relocalize(const Landmark &landmark, util::ChassisPos current, double headingOffset) {
+        if (landmark.type == Landmark::GOAL) {
+            // The goal is straight ahead of the robot, so step back from its center along the heading.
+            // The offset only corrects the heading odometry continues with, the position uses the measured one
+            return {landmark.x - GOAL_CONTACT_IN * std::sin(current.angle),
+                    landmark.y - GOAL_CONTACT_IN * std::cos(current.angle),
+                    current.angle + headingOffset};
+        }
+
+        // Keep the number of full turns odometry has counted, only snap the heading within the current one
+        double angle = landmark.heading + std::round((current.angle - landmark.heading) / (2 * M_PI)) * 2 * M_PI;
+        util::ChassisPos corrected = {current.x, current.y, angle};
+        if (std::fabs(std::sin(landmark.heading)) > 0.5)
+            corrected.x = landmark.x + WALL_CONTACT_IN * std::sin(landmark.heading);
+        else
+            corrected.y = landmark.y + WALL_CONTACT_IN * std::cos(landmark.heading);
+        return corrected;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef _RELOCALIZE_HPP_INCLUDED
+#define _RELOCALIZE_HPP_INCLUDED
+
+#include "util/struct.hpp"
+
+/*
+ * Known things on the field the robot can touch to correct its position.
+ * Same coordinates as odometry: x from -144 (left wall) to 0 (right wall), y from 0 (red driver wall) to 144.
+ */
+namespace field {
+    struct Landmark {
+        enum Type {
+            GOAL, // Robot is pressed into the goal with its intake, facing the goal's center
+            WALL  // Robot is backed square against the wall
+        };
+        Type type;
+        const char *name;
+        // Goals: the center of the goal. Walls: any point on the wall
+        double x, y;
+        // Walls only: the heading of a robot backed square against it, in radians
+        double heading;
+    };
+
+    extern const Landmark bottomLeftGoal, bottomMiddleGoal, bottomRightGoal;
+    extern const Landmark middleLeftGoal, centerGoal, middleRightGoal;
+    extern const Landmark topLeftGoal, topMiddleGoal, topRightGoal;
+    extern const Landmark leftWall, rightWall, bottomWall, topWall;
+
+    /**
+     * Works out where the robot is from the landmark it's touching.
+     *
+     * Against a goal the heading is trusted and the position is moved so the robot sits GOAL_CONTACT_IN away from
+     * the goal's center, whichever angle it came in from.
+     * Against a wall the heading and the distance to that wall are corrected, the position along the wall is kept.
+     *
+     * \param landmark The landmark the robot is touching.
+     *
+     * \param current Where odometry thinks the robot is, angle in radians.
+     *
+     * \param headingOffset Added to the heading the robot continues with, in radians. The position is still worked out
+     * from the current heading. Ignored for walls.
+     *
+     * \return The corrected position, angle in radians.
+     */
+    util::ChassisPos relocalize(const Landmark &landmark, util::ChassisPos current, double headingOffset = 0);
+}
+#endif /* _RELOCALIZE_HPP_INCLUDED */
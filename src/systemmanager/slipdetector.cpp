@@ -0,0 +1,77 @@
+#include "slipdetector.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    /// Slip of one wheel, with the sign flipped for wheels turning backwards so spinning is always positive
+    double slipRatio(double moved, double expected, double minDistance) {
+        double larger = std::fabs(moved) >= std::fabs(expected) ? moved : expected;
+        double ratio = (moved - expected) / std::max({std::fabs(moved), std::fabs(expected), minDistance});
+        return std::clamp(larger < 0 ? -ratio : ratio, -1.0, 1.0);
+    }
+}
+
+SlipDetector::SlipDetector(const Eigen::Matrix<double, 4, 3> &inverseKinematics)
+    : inverseKinematics(inverseKinematics) {
+}
+
+void SlipDetector::reset(util::WheelSpeed distances, uint64_t timestamp) {
+    lastDistances = distances;
+    lastTime = timestamp;
+    tracked = {0, 0, 0};
+    slip = WheelSlip();
+    slip.timestamp = timestamp;
+}
+
+void SlipDetector::track(const util::ChassisSpeed &move) {
+    tracked.x += move.x;
+    tracked.y += move.y;
+    tracked.angle += move.angle;
+}
+
+bool SlipDetector::update(util::WheelSpeed distances, uint64_t timestamp) {
+    bool changed = distances.lf != lastDistances.lf || distances.lr != lastDistances.lr ||
+                   distances.rf != lastDistances.rf || distances.rr != lastDistances.rr;
+    if (!changed && timestamp - lastTime < SLIP_STALE_US)
+        return false;
+
+    util::WheelSpeed moved = {distances.lf - lastDistances.lf, distances.lr - lastDistances.lr,
+                              distances.rf - lastDistances.rf, distances.rr - lastDistances.rr};
+    // The encoders were reset or a reading went wrong
+    if (std::fabs(moved.lf) > ODOM_MOTOR_MAX_STEP_IN || std::fabs(moved.lr) > ODOM_MOTOR_MAX_STEP_IN ||
+        std::fabs(moved.rf) > ODOM_MOTOR_MAX_STEP_IN || std::fabs(moved.rr) > ODOM_MOTOR_MAX_STEP_IN) {
+        reset(distances, timestamp);
+        return false;
+    }
+
+    // How far each wheel should have rolled. The matrix takes (forward, left, counterclockwise)
+    // and gives left front, right front, left rear, right rear
+    Eigen::Vector3d chassis;
+    chassis << tracked.y, -tracked.x, -tracked.angle;
+    Eigen::Vector4d expected = inverseKinematics * chassis;
+
+    double dt = (timestamp - lastTime) / 1000000.0;
+    // Below this speed, a small difference is just encoder resolution
+    double minDistance = SLIP_MIN_SPEED_IN_S * dt;
+    util::WheelSpeed ratio = {slipRatio(moved.lf, expected(0), minDistance), slipRatio(moved.lr, expected(2), minDistance),
+                              slipRatio(moved.rf, expected(1), minDistance), slipRatio(moved.rr, expected(3), minDistance)};
+
+    double alpha = 1 - std::exp(-dt / SLIP_EMA_TIME_S);
+    slip.ratio.lf += (ratio.lf - slip.ratio.lf) * alpha;
+    slip.ratio.lr += (ratio.lr - slip.ratio.lr) * alpha;
+    slip.ratio.rf += (ratio.rf - slip.ratio.rf) * alpha;
+    slip.ratio.rr += (ratio.rr - slip.ratio.rr) * alpha;
+    slip.average = (slip.ratio.lf + slip.ratio.lr + slip.ratio.rf + slip.ratio.rr) / 4.0;
+    slip.contact = slip.average > SLIP_CONTACT_RATIO;
+    slip.timestamp = timestamp;
+
+    lastDistances = distances;
+    lastTime = timestamp;
+    tracked = {0, 0, 0};
+    return true;
+}
+
+WheelSlip SlipDetector::get() {
+    return slip;
+}
@@ -0,0 +1,79 @@
+// Wheel slip detection, kept free of any PROS calls like odometrystep.hpp
+
+#ifndef _SLIPDETECTOR_HPP_INCLUDED
+#define _SLIPDETECTOR_HPP_INCLUDED
+
+#include <cstdint>
+#include "Eigen/Core"
+#include "profiles.hpp"
+#include "util/struct.hpp"
+
+/// How much each drive wheel slips, from the last SlipDetector::update.
+struct WheelSlip {
+    // Per wheel, filtered. 0 when the wheel rolls as fast as the robot moves, towards 1 when it spins faster
+    // (pushing into something), towards -1 when it turns slower than the robot moves (dragged or skidding)
+    util::WheelSpeed ratio = {0, 0, 0, 0};
+    double average = 0;     // Average of the four ratios
+    bool contact = false;   // True while average is above SLIP_CONTACT_RATIO, the robot is pushing into something
+    uint64_t timestamp = 0; // Microseconds, when it was calculated
+};
+
+/**
+ * Compares how far the drive wheels turned with how far the tracking wheels say the robot moved.
+ *
+ * The tracking wheel movement goes through the inverse kinematics matrix to get how far each drive wheel should
+ * have rolled. A wheel that turned further than that is spinning, like when the X-drive pushes into a goal and the
+ * robot stands still. That shows up within a few motor updates, well before the motors stall.
+ *
+ * The odometry task feeds it the tracking wheel movement every step and the drive wheel distances every time
+ * the motors are read. Read the result with Odometry::getSlip().
+ */
+class SlipDetector {
+private:
+    Eigen::Matrix<double, 4, 3> inverseKinematics;
+    util::WheelSpeed lastDistances = {0, 0, 0, 0};
+    // Robot relative movement from the tracking wheels since the last update. x right, y forward, angle clockwise
+    util::ChassisSpeed tracked = {0, 0, 0};
+    uint64_t lastTime = 0;
+    WheelSlip slip;
+
+public:
+    /**
+     * \param inverseKinematics The drive's inverse kinematics matrix, from DriveSubsystem::getIKMatrix().
+     */
+    SlipDetector(const Eigen::Matrix<double, 4, 3> &inverseKinematics);
+
+    /**
+     * Starts over, forgetting any slip so far.
+     *
+     * \param distances How far each drive wheel has rolled so far, from DriveSubsystem::getWheelDistances().
+     *
+     * \param timestamp Microseconds.
+     */
+    void reset(util::WheelSpeed distances, uint64_t timestamp);
+
+    /**
+     * Adds one odometry step of tracking wheel movement.
+     *
+     * \param move How the tracking center moved relative to the robot, in inches and radians.
+     * x to the right, y forward, angle clockwise. Not mirrored for the blue side.
+     */
+    void track(const util::ChassisSpeed &move);
+
+    /**
+     * Compares the drive wheels with the tracking wheel movement since the last update.
+     * Skipped while the motors haven't reported anything new, unless they've been still for SLIP_STALE_US,
+     * so a step the motors missed doesn't look like slip.
+     *
+     * \param distances How far each drive wheel has rolled so far, from DriveSubsystem::getWheelDistances().
+     *
+     * \param timestamp Microseconds.
+     *
+     * \return True if the slip was updated.
+     */
+    bool update(util::WheelSpeed distances, uint64_t timestamp);
+
+    /// \return The slip from the last update.
+    WheelSlip get();
+};
+#endif /* _SLIPDETECTOR_HPP_INCLUDED */
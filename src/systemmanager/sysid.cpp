@@ -0,0 +1,135 @@
+#include "sysid.hpp"
+
+#include <cmath>
+#include "Eigen/QR"
+#include "profiles.hpp"
+#include "io.hpp"
+#include "subsystem.hpp"
+#include "util/util.hpp"
+
+namespace sysid {
+    Result solve(const std::vector<Sample> &samples) {
+        Result result;
+        result.valid = samples.size() > 2 * SYSID_ACCEL_WINDOW;
+        for (int w = 0; w < 4; w++) {
+            result.gains[w] = {DRIVE_FF_KS, DRIVE_FF_KV, DRIVE_FF_KA};
+            result.residual[w] = 0;
+        }
+        if (!result.valid)
+            return result;
+
+        for (int w = 0; w < 4; w++) {
+            // Rows of [sign(velocity), velocity, acceleration] against the voltage
+            Eigen::MatrixXd model(samples.size(), 3);
+            Eigen::VectorXd voltage(samples.size());
+            int rows = 0;
+            for (size_t i = SYSID_ACCEL_WINDOW; i + SYSID_ACCEL_WINDOW < samples.size(); i++) {
+                const Sample &sample = samples[i];
+                double velocity = sample.velocity[w];
+                // Unpowered samples are the motors braking or coasting, and slow ones are mostly static friction
+                if (sample.voltage == 0 || std::fabs(velocity) < SYSID_MIN_VELOCITY_IN_S)
+                    continue;
+
+                // Central difference over a few samples, the motors only report whole RPM
+                const Sample &before = samples[i - SYSID_ACCEL_WINDOW], &after = samples[i + SYSID_ACCEL_WINDOW];
+                double acceleration = (after.velocity[w] - before.velocity[w]) / (after.time - before.time);
+                model.row(rows) << (velocity > 0 ? 1 : -1), velocity, acceleration;
+                voltage(rows) = sample.voltage;
+                rows++;
+            }
+            if (rows < 3) {
+                result.valid = false;
+                continue;
+            }
+
+            Eigen::Vector3d fit = model.topRows(rows).colPivHouseholderQr().solve(voltage.head(rows));
+            result.gains[w] = {fit(0), fit(1), fit(2)};
+            result.residual[w] = std::sqrt((model.topRows(rows) * fit - voltage.head(rows)).squaredNorm() / rows);
+
+            // Negative gains or a kV far from the motor's rating means a wheel slipped or a motor is unplugged
+            result.valid = result.valid && fit(0) >= 0 && fit(2) >= 0 &&
+                           std::fabs(fit(1) - DRIVE_FF_KV) < DRIVE_FF_KV * SYSID_MAX_KV_CHANGE;
+        }
+        return result;
+    }
+
+    namespace {
+        /// One step of the scripted routine
+        struct Phase {
+            double voltage;    // Millivolts at the start of the phase
+            double ramp;       // Millivolts per second added during the phase
+            uint32_t duration; // Milliseconds
+        };
+
+        // Quasistatic forward and back, then a step forward and back, with pauses in between.
+        // Each pair ends up about where it started
+        const Phase routine[] = {
+            {0, SYSID_RAMP_MV_S, 3000}, {0, 0, 1000},
+            {0, -SYSID_RAMP_MV_S, 3000}, {0, 0, 1000},
+            {SYSID_STEP_MV, 0, 1000}, {0, 0, 1000},
+            {-SYSID_STEP_MV, 0, 1000}, {0, 0, 1000}
+        };
+    }
+
+    Result run() {
+        Result result = {};
+        // The motors don't move while disabled, and the driver holds the drive the rest of the time
+        if (pros::competition::is_disabled()) {
+            localStorage.log("Sysid needs the robot enabled");
+            return result;
+        }
+        ActuatorLease lease(ACTUATOR_DRIVE, ARBITER_PRIORITY_TUNING, "sysid");
+        if (!lease.holdsAny()) {
+            localStorage.log("Sysid couldn't get the drive");
+            return result;
+        }
+
+        localStorage.log("Starting drive system identification");
+        FILE *logFile = pros::usd::is_installed() ? fopen(SYSID_LOG_FILE, "w") : NULL;
+        if (logFile != NULL)
+            fprintf(logFile, "time,voltage,lf,lr,rf,rr\n");
+
+        std::vector<Sample> samples;
+        uint32_t start = pros::millis();
+        drive.brake();
+        for (const Phase &phase : routine) {
+            uint32_t phaseStart = pros::millis();
+            uint32_t time = phaseStart;
+            while (time < phaseStart + phase.duration) {
+                double voltage = phase.voltage + phase.ramp * (time - phaseStart) / 1000.0;
+                drive.setWheelVoltage({voltage, voltage, voltage, voltage});
+
+                util::WheelSpeed velocity = drive.getWheelVelocities();
+                Sample sample = {(time - start) / 1000.0, voltage, {velocity.lf, velocity.lr, velocity.rf, velocity.rr}};
+                samples.push_back(sample);
+                if (logFile != NULL)
+                    fprintf(logFile, "%lu,%.0f,%f,%f,%f,%f\n", (long unsigned int)time, voltage, velocity.lf,
+                            velocity.lr, velocity.rf, velocity.rr);
+                pros::Task::delay_until(&time, SYSID_SAMPLE_MS);
+            }
+        }
+        drive.moveRPM(0);
+        if (logFile != NULL)
+            fclose(logFile);
+
+        result = solve(samples);
+        char logBuf[150];
+        const char *names[] = {"lf", "lr", "rf", "rr"};
+        for (int w = 0; w < 4; w++) {
+            sprintf(logBuf, "Sysid %s %s: kS %.1f, kV %.2f, kA %.3f (rms %.1f mV)", names[w],
+                    result.valid ? "done" : "rejected", result.gains[w].kS, result.gains[w].kV, result.gains[w].kA,
+                    result.residual[w]);
+            localStorage.log(logBuf);
+        }
+
+        if (result.valid) {
+            for (int w = 0; w < 4; w++) {
+                robotConfigs.driveKS[w] = result.gains[w].kS;
+                robotConfigs.driveKV[w] = result.gains[w].kV;
+                robotConfigs.driveKA[w] = result.gains[w].kA;
+            }
+            localStorage.writeConfigs();
+        }
+        return result;
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef _SYSID_HPP_INCLUDED
+#define _SYSID_HPP_INCLUDED
+
+#include <vector>
+#include "util/math/feedforward.hpp"
+
+/*
+ * Measures the feedforward gains of each drive wheel (see feedforward.hpp).
+ *
+ * The robot drives forward and back through a quasistatic test, where the voltage rises slowly so acceleration
+ * barely matters, and a step test, where a fixed voltage is applied from a stop so acceleration dominates.
+ * The wheel velocities are logged, and voltage = kS * sign(velocity) + kV * velocity + kA * acceleration is fitted
+ * to both tests at once with least squares, separately for every wheel.
+ */
+namespace sysid {
+    /// One reading of the drive motors.
+    struct Sample {
+        double time;        // Seconds
+        double voltage;     // Millivolts applied to every wheel, in the direction of driving forward
+        double velocity[4]; // Inches per second (lf, lr, rf, rr)
+    };
+
+    struct Result {
+        bool valid;                      // False if the data wasn't good enough to trust the gains below
+        util::FeedforwardGains gains[4]; // lf, lr, rf, rr
+        double residual[4];              // RMS error of each wheel's fit, in millivolts
+    };
+
+    /**
+     * Fits the feedforward gains to logged data. Doesn't use any PROS calls.
+     *
+     * \param samples The readings, in order, taken at a fixed rate.
+     *
+     * \return The fitted gains.
+     */
+    Result solve(const std::vector<Sample> &samples);
+
+    /**
+     * Drives the sysid routine, fits the gains and saves them to the SD card config if they look sane.
+     * Takes about 12 seconds and needs about 4 feet of clear space in front of the robot.
+     * The drive picks the new gains up right away.
+     * Needs the robot enabled. Takes the drive from the driver with ARBITER_PRIORITY_TUNING until it's done.
+     *
+     * \return The fitted gains.
+     */
+    Result run();
+}
+#endif /* _SYSID_HPP_INCLUDED */
@@ -0,0 +1,64 @@
+#include "completion.hpp"
+
+void util::Completion::start() {
+    pending++;
+}
+
+void util::Completion::finish(int count) {
+    if ((pending -= count) > 0)
+        return;
+    for (std::atomic<pros::task_t> &waiter : waiters) {
+        pros::task_t task = waiter;
+        if (task != NULL)
+            pros::c::task_notify(task);
+    }
+}
+
+bool util::Completion::isDone() const {
+    return pending <= 0;
+}
+
+int util::Completion::remaining() const {
+    return pending;
+}
+
+bool util::Completion::wait(int timeoutMs) {
+    if (isDone())
+        return true;
+
+    // Registers first, so a job finishing right after the check below still wakes us up
+    pros::task_t self = pros::c::task_get_current();
+    std::atomic<pros::task_t> *slot = NULL;
+    for (std::atomic<pros::task_t> &waiter : waiters) {
+        pros::task_t empty = NULL;
+        if (waiter.compare_exchange_strong(empty, self)) {
+            slot = &waiter;
+            break;
+        }
+    }
+    uint32_t startTime = pros::millis();
+    if (slot == NULL) {
+        // Every slot is taken, so nothing will notify us. Still wait, only a little later than the others
+        while (!isDone()) {
+            if (timeoutMs != NO_TIME_OUT && pros::millis() - startTime >= (uint32_t)timeoutMs)
+                return false;
+            pros::delay(COMPLETION_POLL_MS);
+        }
+        return true;
+    }
+
+    pros::c::task_notify_take(true, 0); // Clears any old notification so it isn't mistaken for this one
+    while (!isDone()) {
+        uint32_t timeout = TIMEOUT_MAX;
+        if (timeoutMs != NO_TIME_OUT) {
+            uint32_t elapsed = pros::millis() - startTime;
+            if (elapsed >= (uint32_t)timeoutMs)
+                break;
+            timeout = timeoutMs - elapsed;
+        }
+        // Checked again after waking up, in case the notification was meant for something else
+        pros::c::task_notify_take(true, timeout);
+    }
+    *slot = NULL;
+    return isDone();
+}
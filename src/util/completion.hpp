@@ -0,0 +1,57 @@
+#ifndef _UTIL_COMPLETION_HPP_INCLUDED
+#define _UTIL_COMPLETION_HPP_INCLUDED
+
+#include <atomic>
+#include "api.h"
+#include "util/util.hpp"
+
+#define COMPLETION_MAX_WAITERS 4
+// How often a task that didn't get a waiter slot checks isDone(), in milliseconds
+#define COMPLETION_POLL_MS 5
+
+namespace util {
+    /**
+     * Lets tasks block until an asynchronous subsystem is done with its work, without polling.
+     *
+     * The subsystem counts each job it starts and finishes. When the last one finishes, every task blocked in wait()
+     * gets a task notification and wakes up on the next scheduler tick, instead of on the next poll.
+     * Never allocates, so it can be a member of the global subsystems.
+     */
+    class Completion {
+    private:
+        /// Jobs that were started and haven't finished yet.
+        std::atomic<int> pending{0};
+        /// Tasks blocked in wait(), NULL where free. Notified when pending drops to 0.
+        std::atomic<pros::task_t> waiters[COMPLETION_MAX_WAITERS] = {};
+
+    public:
+        /// Counts a new job. isDone() is false from the moment this returns.
+        void start();
+
+        /**
+         * Marks jobs as finished, waking up the waiting tasks if none are left.
+         *
+         * \param count How many jobs finished, e.g. moves dropped from a queue before they started.
+         */
+        void finish(int count = 1);
+
+        /// \return True if no jobs are running or waiting to run.
+        bool isDone() const;
+
+        /// \return The number of jobs that were started and haven't finished yet.
+        int remaining() const;
+
+        /**
+         * Blocks the current task until every job has finished.
+         * Uses the calling task's notification, like Odometry::send, so a task can only wait on one thing at a time.
+         *
+         * \param timeoutMs The maximum time to wait in milliseconds, or NO_TIME_OUT to wait as long as it takes.
+         *
+         * If COMPLETION_MAX_WAITERS tasks are already waiting, polls isDone() every COMPLETION_POLL_MS instead.
+         *
+         * \return True if the jobs finished, false if it timed out.
+         */
+        bool wait(int timeoutMs = NO_TIME_OUT);
+    };
+}
+#endif /* _UTIL_COMPLETION_HPP_INCLUDED */
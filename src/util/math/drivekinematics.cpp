@@ -26,6 +26,11 @@ namespace util {
         return wheelSpeed;
     }
 
+    Eigen::Matrix<double, 4, 3> InverseKinematics::getMatrix(Pos2d Cor) {
+        updateInverseKinematics(Cor);
+        return inverseKinematics;
+    }
+
     void InverseKinematics::updateInverseKinematics(Pos2d Cor) {
         if (COR == Cor && initialized)
             return;
@@ -47,4 +52,23 @@ namespace util {
             lr.x - lr.y, 1, -1, -(rr.x + rr.y);
         inverseKinematics /= M_SQRT2;
     }
-}
\ No newline at end of file
+
+    ForwardKinematics::ForwardKinematics(const Eigen::Matrix<double, 4, 3> &inverseKinematics) {
+        // Least squares solution of inverseKinematics * x = I, which is the pseudo-inverse since the matrix has full column rank
+        forwardKinematics = inverseKinematics.colPivHouseholderQr().solve(Eigen::Matrix4d::Identity());
+    }
+
+    ChassisSpeed ForwardKinematics::toChassisSpeed(WheelSpeed wheelSpeed) {
+        Eigen::Vector4d wheelsVector;
+        wheelsVector << wheelSpeed.lf, wheelSpeed.rf, wheelSpeed.lr, wheelSpeed.rr;
+
+        Eigen::Vector3d chassisSpeedsVector = forwardKinematics * wheelsVector;
+
+        // Back from (forward, left, counterclockwise) to the frame used outside of these classes
+        return {-chassisSpeedsVector(1), chassisSpeedsVector(0), -chassisSpeedsVector(2)};
+    }
+
+    Eigen::Matrix<double, 3, 4> ForwardKinematics::getMatrix() {
+        return forwardKinematics;
+    }
+}
@@ -18,6 +18,15 @@ namespace util {
          * \param COR the center of rotation relative to the center of the robot. Defaults to one that's previously set.
          */
         WheelSpeed toWheelSpeed(ChassisSpeed, Pos2d = Pos2d());
+
+        /**
+         * Gets the matrix toWheelSpeed multiplies by. Used to plan around the wheel limits (see Trajectory).
+         * 
+         * \param COR the center of rotation relative to the center of the robot. Defaults to one that's previously set.
+         * 
+         * \return Wheel speeds (left front, right front, left rear, right rear) from a (forward, left, counterclockwise) chassis speed.
+         */
+        Eigen::Matrix<double, 4, 3> getMatrix(Pos2d = Pos2d());
         bool initialized = false;
         
     private:
@@ -44,5 +53,37 @@ namespace util {
         /// Updates the inverse kinematics matrix to match a new center of rotation
         void updateInverseKinematics(Pos2d Cor);
     };
+
+    /**
+     * The other way around from InverseKinematics: the chassis speed that best explains a set of wheel speeds.
+     * Four wheels over-determine three chassis axes, so wheels that slip or disagree are averaged out in the
+     * least squares sense. The pseudo-inverse is solved once up front, every call is a single 3x4 multiply.
+     */
+    class ForwardKinematics {
+    public:
+        /**
+         * \param inverseKinematics The matrix from InverseKinematics::getMatrix() to invert.
+         */
+        ForwardKinematics(const Eigen::Matrix<double, 4, 3> &inverseKinematics);
+
+        /**
+         * Calculates the chassis speed from the wheel speeds using forward kinematics.
+         * Works with distances just as well, turning how far each wheel rolled into how far the robot moved.
+         *
+         * \param wheelSpeed the speed of each wheel, in the units the inverse kinematics matrix was built with.
+         *
+         * \return The chassis speed relative to the robot. x to the right, y forward, angle clockwise.
+         */
+        ChassisSpeed toChassisSpeed(WheelSpeed);
+
+        /**
+         * \return (forward, left, counterclockwise) chassis speed from wheel speeds (left front, right front, left rear, right rear).
+         */
+        Eigen::Matrix<double, 3, 4> getMatrix();
+
+    private:
+        /// The pseudo-inverse of the inverse kinematics matrix
+        Eigen::Matrix<double, 3, 4> forwardKinematics;
+    };
 }
 #endif /* _DRIVEKINEMATICS_HPP_INCLUDED */
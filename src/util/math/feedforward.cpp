@@ -0,0 +1,13 @@
+#include "feedforward.hpp"
+
+#include <algorithm>
+#include "profiles.hpp"
+
+util::Feedforward::Feedforward(FeedforwardGains gains) : gains(gains) {
+}
+
+double util::Feedforward::calculate(double velocity, double acceleration) const {
+    // Static friction is faded in near 0, otherwise it flips sign every loop while the PID controllers settle
+    double direction = std::clamp(velocity / FEEDFORWARD_STATIC_DEADBAND_IN_S, -1.0, 1.0);
+    return std::clamp(gains.kS * direction + gains.kV * velocity + gains.kA * acceleration, -12000.0, 12000.0);
+}
@@ -0,0 +1,37 @@
+#ifndef _FEEDFORWARD_HPP_INCLUDED
+#define _FEEDFORWARD_HPP_INCLUDED
+
+namespace util {
+    /// Gains of a motor model: voltage = kS * sign(velocity) + kV * velocity + kA * acceleration
+    struct FeedforwardGains {
+        double kS; // Millivolts to get past static friction
+        double kV; // Millivolts per inch per second
+        double kA; // Millivolts per inch per second squared
+    };
+
+    /**
+     * Turns the velocity and acceleration a wheel should have into the voltage it needs, so the motors can be driven
+     * with moveVoltage instead of relying on the PID controller inside moveVelocity.
+     * The gains are measured per wheel by the sysid routine (see sysid.hpp).
+     *
+     * Doesn't use any PROS calls.
+     */
+    class Feedforward {
+    public:
+        Feedforward(FeedforwardGains gains);
+
+        /**
+         * Calculates the voltage for a wheel.
+         *
+         * \param velocity The wheel's target velocity in inches per second.
+         *
+         * \param acceleration The wheel's target acceleration in inches per second squared.
+         *
+         * \return The voltage in millivolts, within what moveVoltage takes.
+         */
+        double calculate(double velocity, double acceleration = 0) const;
+
+        FeedforwardGains gains;
+    };
+}
+#endif /* _FEEDFORWARD_HPP_INCLUDED */
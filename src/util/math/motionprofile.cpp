@@ -0,0 +1,131 @@
+#include "motionprofile.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+util::MotionProfile::MotionProfile() {
+}
+
+util::MotionProfile util::MotionProfile::trapezoid(double distance, ProfileConstraints constraints,
+                                                   double startVelocity, double endVelocity) {
+    MotionProfile profile;
+    profile.direction = distance < 0 ? -1 : 1;
+    double d = std::fabs(distance);
+    double a = constraints.maxAcceleration;
+    double vs = startVelocity;
+
+    // The end velocity has to be reachable from the start velocity within the distance
+    double ve = std::clamp(endVelocity, std::sqrt(std::max(0.0, vs * vs - 2 * a * d)), std::sqrt(vs * vs + 2 * a * d));
+    // Fastest speed reachable while still being able to slow down to the end velocity in time
+    double vp = std::min(std::sqrt((2 * a * d + vs * vs + ve * ve) / 2.0), constraints.maxVelocity);
+    if (vp <= 0)
+        return profile;
+
+    // Starting faster than the limit slows down to it first
+    double a1 = vp >= vs ? a : -a;
+    double d1 = (vp * vp - vs * vs) / (2 * a1);
+    double d3 = (vp * vp - ve * ve) / (2 * a);
+
+    profile.segments[0] = {0, 0, vs, 0, 0};
+    profile.addSegment((vp - vs) / a1, a1, 0);
+    profile.addSegment(std::max(0.0, d - d1 - d3) / vp, 0, 0);
+    profile.addSegment((vp - ve) / a, -a, 0);
+    return profile;
+}
+
+util::MotionProfile util::MotionProfile::sCurve(double distance, ProfileConstraints constraints) {
+    MotionProfile profile;
+    profile.direction = distance < 0 ? -1 : 1;
+    double d = std::fabs(distance);
+    double v = constraints.maxVelocity;
+    double a = constraints.maxAcceleration;
+    double j = constraints.maxJerk;
+    if (d <= 0)
+        return profile;
+
+    // Can't reach the acceleration limit before reaching the velocity limit
+    if (v * j < a * a)
+        a = std::sqrt(v * j);
+
+    // Too short to reach the velocity limit. Lowers the peak velocity so speeding up and slowing down cover
+    // the distance exactly, first keeping the acceleration limit, then without reaching it either
+    if (v * (v / a + a / j) > d) {
+        double r = a / j;
+        v = a / 2.0 * (std::sqrt(r * r + 4 * d / a) - r);
+        if (v * j < a * a) {
+            v = std::cbrt(d * d * j / 4.0);
+            a = std::sqrt(v * j);
+        }
+    }
+
+    double jerkTime = a / j;
+    double constantTime = std::max(0.0, v / a - jerkTime);
+    double cruiseTime = std::max(0.0, d - v * (v / a + a / j)) / v;
+
+    profile.segments[0] = {0, 0, 0, 0, 0};
+    profile.addSegment(jerkTime, 0, j);
+    profile.addSegment(constantTime, a, 0);
+    profile.addSegment(jerkTime, a, -j);
+    profile.addSegment(cruiseTime, 0, 0);
+    profile.addSegment(jerkTime, 0, -j);
+    profile.addSegment(constantTime, -a, 0);
+    profile.addSegment(jerkTime, -a, j);
+    return profile;
+}
+
+util::MotionProfile util::MotionProfile::generate(Type type, double distance, ProfileConstraints constraints,
+                                                  double startVelocity, double endVelocity) {
+    if (type == S_CURVE && startVelocity == 0 && endVelocity == 0)
+        return sCurve(distance, constraints);
+    return trapezoid(distance, constraints, startVelocity, endVelocity);
+}
+
+void util::MotionProfile::addSegment(double time, double acceleration, double jerk) {
+    if (time <= 0)
+        return;
+
+    // The first segment's start state is set before anything is added
+    ProfileState start = {segments[0].position, segments[0].velocity, acceleration};
+    if (segmentCount > 0) {
+        start = at(segments[segmentCount - 1], totalTime - segments[segmentCount - 1].start);
+        start.acceleration = acceleration;
+    }
+    segments[segmentCount++] = {totalTime, start.position, start.velocity, start.acceleration, jerk};
+    totalTime += time;
+}
+
+util::ProfileState util::MotionProfile::at(const Segment &segment, double time) {
+    return {segment.position + segment.velocity * time + segment.acceleration * time * time / 2.0 +
+                segment.jerk * time * time * time / 6.0,
+            segment.velocity + segment.acceleration * time + segment.jerk * time * time / 2.0,
+            segment.acceleration + segment.jerk * time};
+}
+
+util::ProfileState util::MotionProfile::sample(double time) const {
+    if (segmentCount == 0)
+        return {0, 0, 0};
+
+    ProfileState state;
+    if (time <= 0) {
+        state = {0, segments[0].velocity, 0};
+    } else if (time >= totalTime) {
+        const Segment &last = segments[segmentCount - 1];
+        state = at(last, totalTime - last.start);
+        state.acceleration = 0;
+    } else {
+        // At most 7 segments, so this is a constant amount of work
+        int i = segmentCount - 1;
+        while (segments[i].start > time)
+            i--;
+        state = at(segments[i], time - segments[i].start);
+    }
+    return {state.position * direction, state.velocity * direction, state.acceleration * direction};
+}
+
+double util::MotionProfile::duration() const {
+    return totalTime;
+}
+
+double util::MotionProfile::distance() const {
+    return sample(totalTime).position;
+}
@@ -0,0 +1,106 @@
+#ifndef _MOTIONPROFILE_HPP_INCLUDED
+#define _MOTIONPROFILE_HPP_INCLUDED
+
+namespace util {
+    /// Where a motion profile wants the robot to be at one point in time.
+    struct ProfileState {
+        double position;     // Distance from the start, inches or radians
+        double velocity;     // Per second
+        double acceleration; // Per second squared
+    };
+
+    /// Limits a motion profile stays within. All of them are positive.
+    struct ProfileConstraints {
+        double maxVelocity;
+        double maxAcceleration;
+        double maxJerk; // Only used by S-curves
+    };
+
+    /**
+     * A time parameterized motion along one axis, like the distance to a point or the change in heading.
+     *
+     * Made of at most 7 segments of constant jerk, each sampled from its closed form,
+     * so sampling takes the same time no matter how long the move is. Fixed size and free of PROS calls.
+     */
+    class MotionProfile {
+    public:
+        enum Type {
+            NONE,      // No profile, the move is driven by the PID controllers alone
+            TRAPEZOID, // Acceleration jumps between the limit and 0
+            S_CURVE    // Acceleration ramps up and down within the jerk limit, so the robot doesn't jolt
+        };
+
+        /// An empty profile that stays at 0.
+        MotionProfile();
+
+        /**
+         * Accelerates, cruises and decelerates over a distance with a limited acceleration.
+         *
+         * \param distance How far to move. Negative to move backwards.
+         *
+         * \param constraints The velocity and acceleration limits. maxJerk is ignored.
+         *
+         * \param startVelocity The velocity at the start, in the direction of distance.
+         * If it's too fast to stop in time, the profile ends as slow as it can.
+         *
+         * \param endVelocity The velocity at the end, in the direction of distance.
+         */
+        static MotionProfile trapezoid(double distance, ProfileConstraints constraints, double startVelocity = 0,
+                                       double endVelocity = 0);
+
+        /**
+         * Moves over a distance from a stop to a stop, with limited velocity, acceleration and jerk.
+         * Lowers the peak velocity and acceleration on moves too short to reach them.
+         *
+         * \param distance How far to move. Negative to move backwards.
+         *
+         * \param constraints The velocity, acceleration and jerk limits.
+         */
+        static MotionProfile sCurve(double distance, ProfileConstraints constraints);
+
+        /**
+         * Picks the profile for a move. S-curves always go from a stop to a stop, so a move that starts or ends while
+         * moving uses a trapezoid instead.
+         *
+         * \param type TRAPEZOID or S_CURVE.
+         *
+         * \param startVelocity The velocity at the start, in the direction of distance.
+         *
+         * \param endVelocity The velocity at the end, in the direction of distance.
+         */
+        static MotionProfile generate(Type type, double distance, ProfileConstraints constraints,
+                                      double startVelocity = 0, double endVelocity = 0);
+
+        /**
+         * Finds where the profile is at a point in time.
+         *
+         * \param time Seconds since the start of the profile. Holds the start or end state outside of the profile.
+         */
+        ProfileState sample(double time) const;
+
+        /// \return How long the profile takes in seconds.
+        double duration() const;
+
+        /// \return The total distance, negative if moving backwards.
+        double distance() const;
+
+    private:
+        // One stretch of constant jerk, starting from its own position, velocity and acceleration
+        struct Segment {
+            double start; // Time in seconds
+            double position, velocity, acceleration, jerk;
+        };
+
+        Segment segments[7];
+        int segmentCount = 0;
+        double totalTime = 0;
+        double direction = 1; // Profiles are built forward and mirrored when the distance is negative
+
+        /// Adds a segment that starts where the last one ended. Skipped if it takes no time.
+        void addSegment(double time, double acceleration, double jerk);
+
+        /// The state at a time into a segment
+        static ProfileState at(const Segment &segment, double time);
+    };
+}
+#endif /* _MOTIONPROFILE_HPP_INCLUDED */
@@ -0,0 +1,108 @@
+#include "mpc.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include "Eigen/LU"
+
+namespace {
+    // Field velocity from a chassis velocity of (forward, left, counterclockwise), at a heading positive clockwise
+    Eigen::Matrix3d toField(double heading) {
+        double s = std::sin(heading), c = std::cos(heading);
+        Eigen::Matrix3d m;
+        m << s, -c, 0,
+             c, s, 0,
+             0, 0, -1;
+        return m;
+    }
+}
+
+util::HolonomicMpc::HolonomicMpc(const Eigen::Matrix<double, 4, 3> &inverseKinematics, MpcWeights weights, double step)
+    : weights(weights), step(step), inverseKinematics(inverseKinematics) {
+    // Least squares chassis speed from the wheel speeds
+    forwardKinematics = (inverseKinematics.transpose() * inverseKinematics).inverse() * inverseKinematics.transpose();
+    reset();
+}
+
+void util::HolonomicMpc::reset() {
+    warm = false;
+    inputs.setZero();
+    iterations = 0;
+}
+
+util::WheelSpeed util::HolonomicMpc::solve(ChassisPos pos, const TrajectoryState (&reference)[HORIZON + 1],
+                                           double maxWheelSpeed, double elapsed) {
+    // Works relative to where the reference is now, so headings don't wrap part way through the horizon
+    const ChassisPos &origin = reference[0].pos;
+    Eigen::Vector3d error(pos.x - origin.x, pos.y - origin.y, std::remainder(pos.angle - origin.angle, 2 * M_PI));
+    double referenceAngle = 0;
+
+    prediction.setZero();
+    for (int k = 0; k < HORIZON; k++) {
+        // Pose change from step k's wheel speeds, linearized around the reference's heading
+        Eigen::Matrix3d rotation = toField(reference[k].pos.angle);
+        Eigen::Matrix<double, 3, 4> effect = step * rotation * forwardKinematics;
+        for (int later = k; later < HORIZON; later++)
+            prediction.block<3, 4>(3 * later, 4 * k) = effect;
+
+        // The wheel speeds that drive the reference's own velocity
+        const ChassisSpeed &vel = reference[k].vel;
+        referenceInputs.segment<4>(4 * k) = inverseKinematics * rotation.transpose() * Eigen::Vector3d(vel.x, vel.y, vel.angle);
+
+        referenceAngle += std::remainder(reference[k + 1].pos.angle - reference[k].pos.angle, 2 * M_PI);
+        offset.segment<3>(3 * k) = error - Eigen::Vector3d(reference[k + 1].pos.x - origin.x,
+                                                           reference[k + 1].pos.y - origin.y, referenceAngle);
+    }
+
+    // cost = |prediction * inputs + offset|² weighted + effort * |inputs - referenceInputs|²
+    Eigen::Vector3d poseWeights(weights.position, weights.position, weights.heading);
+    for (int k = 0; k < HORIZON; k++)
+        weighted.middleRows<3>(3 * k) = poseWeights.asDiagonal() * prediction.middleRows<3>(3 * k);
+    hessian.noalias() = prediction.transpose() * weighted;
+    hessian.diagonal().array() += weights.effort;
+    linear.noalias() = weighted.transpose() * offset;
+    linear -= weights.effort * referenceInputs;
+
+    // Largest step that can't overshoot, from the largest row sum bounding the largest eigenvalue
+    double lipschitz = hessian.cwiseAbs().rowwise().sum().maxCoeff();
+
+    // Starts from the last solution, which is only one control loop old, or from the reference's wheel speeds.
+    // The horizon has moved on by elapsed since, so each step takes the old plan's speeds from that much later,
+    // blending between the steps it falls between and holding the last step past the end
+    if (!warm) {
+        inputs = referenceInputs;
+    } else {
+        for (int k = 0; k < HORIZON; k++) {
+            double t = k + std::max(elapsed, 0.0) / step;
+            int from = std::min((int)t, HORIZON - 1), to = std::min(from + 1, HORIZON - 1);
+            double blend = std::min(t - from, 1.0);
+            ahead.segment<4>(4 * k) = (1 - blend) * inputs.segment<4>(4 * from) + blend * inputs.segment<4>(4 * to);
+        }
+        inputs = ahead;
+    }
+    inputs = inputs.cwiseMax(-maxWheelSpeed).cwiseMin(maxWheelSpeed);
+    ahead = inputs;
+    double momentum = 1;
+    for (iterations = 1; iterations <= MPC_MAX_ITERATIONS; iterations++) {
+        last = inputs;
+        gradient.noalias() = hessian * ahead;
+        gradient += linear;
+        inputs = (ahead - gradient / lipschitz).cwiseMax(-maxWheelSpeed).cwiseMin(maxWheelSpeed);
+        if ((inputs - last).cwiseAbs().maxCoeff() < MPC_TOLERANCE_IN_S)
+            break;
+        double nextMomentum = (1 + std::sqrt(1 + 4 * momentum * momentum)) / 2.0;
+        ahead = inputs + (momentum - 1) / nextMomentum * (inputs - last);
+        momentum = nextMomentum;
+    }
+    iterations = std::min(iterations, MPC_MAX_ITERATIONS);
+    warm = true;
+    return {inputs(0), inputs(2), inputs(1), inputs(3)};
+}
+
+util::WheelSpeed util::HolonomicMpc::getAcceleration() const {
+    Eigen::Vector4d change = (inputs.segment<4>(4) - inputs.head<4>()) / step;
+    return {change(0), change(2), change(1), change(3)};
+}
+
+int util::HolonomicMpc::getIterations() const {
+    return iterations;
+}
@@ -0,0 +1,88 @@
+#ifndef _MPC_HPP_INCLUDED
+#define _MPC_HPP_INCLUDED
+
+#include "Eigen/Core"
+#include "profiles.hpp"
+#include "util/struct.hpp"
+#include "util/math/trajectory.hpp"
+
+namespace util {
+    /// How much the model predictive controller cares about each kind of error. Defaults come from profiles.hpp
+    struct MpcWeights {
+        double position = MPC_POSITION_WEIGHT; // Per square inch away from the reference
+        double heading = MPC_HEADING_WEIGHT;   // Per square radian away from the reference
+        double effort = MPC_EFFORT_WEIGHT;     // Per square inch per second of wheel speed away from the reference's
+    };
+
+    /**
+     * Linear model predictive controller that tracks a reference with the X-drive.
+     *
+     * Predicts the field pose over a short horizon from the four wheel speeds, through the forward kinematics
+     * (the pseudo-inverse of the inverse kinematics matrix) turned into the field frame at the reference's heading.
+     * The wheel speeds over the whole horizon are then picked together, so the coupling between the wheels and their
+     * top speed are part of the problem instead of being normalized away afterwards.
+     *
+     * The problem is a small dense QP with a box on every wheel speed, solved with accelerated projected gradient
+     * and warm started from the last solution.
+     * Everything is fixed size and kept in the object, so solving never allocates and barely uses the stack.
+     * Free of PROS calls so it can be benchmarked off the robot (see tools/mpcbench.cpp).
+     */
+    class HolonomicMpc {
+    public:
+        static constexpr int HORIZON = MPC_HORIZON; // Number of steps predicted
+        static constexpr int INPUTS = 4 * HORIZON;  // Every wheel's speed on every step
+
+        /**
+         * \param inverseKinematics Wheel speeds from (forward, left, counterclockwise) chassis speeds,
+         * from InverseKinematics::getMatrix().
+         *
+         * \param weights The cost of each kind of error.
+         *
+         * \param step Seconds between the predicted steps.
+         */
+        HolonomicMpc(const Eigen::Matrix<double, 4, 3> &inverseKinematics, MpcWeights weights = MpcWeights(),
+                     double step = MPC_STEP_S);
+
+        /// Forgets the last solution, so the next solve starts from the reference's wheel speeds.
+        void reset();
+
+        /**
+         * Picks the wheel speeds to apply now.
+         *
+         * \param pos Where the robot is, angle in radians.
+         *
+         * \param reference Where the robot should be now and on each step of the horizon, step seconds apart.
+         * Headings shouldn't jump by a full turn from one step to the next.
+         *
+         * \param maxWheelSpeed The fastest any wheel may go, in inches per second.
+         *
+         * \param elapsed Seconds since the last solve. The last solution is moved along by this much before it's used
+         * as the starting point, so it lines up with the new horizon.
+         *
+         * \return The wheel speeds in inches per second.
+         */
+        WheelSpeed solve(ChassisPos pos, const TrajectoryState (&reference)[HORIZON + 1], double maxWheelSpeed,
+                         double elapsed);
+
+        /// \return The change in wheel speeds the last solution plans over the next step, in inches per second squared.
+        WheelSpeed getAcceleration() const;
+
+        /// \return The number of iterations the last solve took.
+        int getIterations() const;
+
+    private:
+        MpcWeights weights;
+        double step;
+        Eigen::Matrix<double, 4, 3> inverseKinematics;
+        Eigen::Matrix<double, 3, 4> forwardKinematics;
+
+        Eigen::Matrix<double, 3 * HORIZON, INPUTS> prediction; // Pose change on each step from all the wheel speeds
+        Eigen::Matrix<double, 3 * HORIZON, INPUTS> weighted;   // prediction with the rows scaled by the weights
+        Eigen::Matrix<double, INPUTS, INPUTS> hessian;
+        Eigen::Matrix<double, INPUTS, 1> linear, inputs, referenceInputs, last, ahead, gradient;
+        Eigen::Matrix<double, 3 * HORIZON, 1> offset; // Predicted error if every wheel stood still
+        bool warm = false;
+        int iterations = 0;
+    };
+}
+#endif /* _MPC_HPP_INCLUDED */
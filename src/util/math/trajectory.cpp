@@ -0,0 +1,213 @@
+#include "trajectory.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Uniform Catmull-Rom spline between p1 and p2, with p0 and p3 as the neighbours shaping it
+    double catmullRom(double p0, double p1, double p2, double p3, double u) {
+        return 0.5 * (2 * p1 + (p2 - p0) * u + (2 * p0 - 5 * p1 + 4 * p2 - p3) * u * u +
+                      (3 * p1 - p0 - 3 * p2 + p3) * u * u * u);
+    }
+
+    // Wheel speeds per unit of path speed at one node: the chassis movement per inch along the path,
+    // turned into the robot's frame and through the inverse kinematics matrix
+    Eigen::Vector4d wheelRates(double dx, double dy, double dHeading, double heading,
+                               const Eigen::Matrix<double, 4, 3> &inverseKinematics) {
+        double forward = dx * std::sin(heading) + dy * std::cos(heading);
+        double right = dx * std::cos(heading) - dy * std::sin(heading);
+        return inverseKinematics * Eigen::Vector3d(forward, -right, -dHeading);
+    }
+
+    // Range of path acceleration that keeps every wheel within its acceleration limit at a squared path speed.
+    // Wheel acceleration is rate * path acceleration + change in rate per inch * path speed²
+    void accelerationRange(const Eigen::Vector4d &rate, const Eigen::Vector4d &rateChange, double speed2,
+                           double maxAcceleration, double &low, double &high) {
+        low = -INFINITY;
+        high = INFINITY;
+        for (int w = 0; w < 4; w++) {
+            if (std::fabs(rate(w)) < 1e-9)
+                continue;
+            double a = (-maxAcceleration - rateChange(w) * speed2) / rate(w);
+            double b = (maxAcceleration - rateChange(w) * speed2) / rate(w);
+            low = std::max(low, std::min(a, b));
+            high = std::min(high, std::max(a, b));
+        }
+    }
+}
+
+util::Trajectory::Trajectory() {
+    nodes.push_back({0, 0, 0, 0, 0, 0, 0, 0, 0});
+}
+
+util::Trajectory util::Trajectory::plan(ChassisPos start, const std::vector<TrajectoryWaypoint> &waypoints,
+                                        const Eigen::Matrix<double, 4, 3> &inverseKinematics,
+                                        TrajectoryConstraints constraints) {
+    Trajectory trajectory;
+    std::vector<Node> &nodes = trajectory.nodes;
+    nodes[0] = {0, 0, start.x, start.y, start.angle, 0, 0, 0, 0};
+
+    // The start and every waypoint, with the ends repeated so the first and last pieces of the spline have neighbours
+    std::vector<TrajectoryWaypoint> points = {{start.x, start.y, start.angle}, {start.x, start.y, start.angle}};
+    points.insert(points.end(), waypoints.begin(), waypoints.end());
+    points.push_back(points.back());
+
+    // Headings to blend between, by distance along the path. Unwrapped so the robot turns the short way
+    std::vector<std::pair<double, double>> headings = {{0, start.angle}};
+
+    for (size_t i = 1; i + 2 < points.size(); i++) {
+        const TrajectoryWaypoint &p0 = points[i - 1], &p1 = points[i], &p2 = points[i + 1], &p3 = points[i + 2];
+        int steps = std::max(1, (int)std::ceil(std::hypot(p2.x - p1.x, p2.y - p1.y) / constraints.spacing));
+        for (int step = 1; step <= steps; step++) {
+            double u = step / (double)steps;
+            double x = catmullRom(p0.x, p1.x, p2.x, p3.x, u);
+            double y = catmullRom(p0.y, p1.y, p2.y, p3.y, u);
+            double ds = std::hypot(x - nodes.back().x, y - nodes.back().y);
+            if (ds < 1e-9)
+                continue;
+            nodes.push_back({0, nodes.back().distance + ds, x, y, 0, 0, 0, 0, 0});
+        }
+        if (p2.heading) {
+            double last = headings.back().second;
+            headings.push_back({nodes.back().distance, last + std::remainder(*p2.heading - last, 2 * M_PI)});
+        }
+    }
+
+    // Blends the heading linearly with distance between the waypoints that have one
+    size_t k = 0;
+    for (Node &node : nodes) {
+        while (k + 1 < headings.size() && headings[k + 1].first < node.distance)
+            k++;
+        if (k + 1 < headings.size() && headings[k + 1].first > headings[k].first) {
+            double t = (node.distance - headings[k].first) / (headings[k + 1].first - headings[k].first);
+            node.heading = headings[k].second + t * (headings[k + 1].second - headings[k].second);
+        } else
+            node.heading = headings[k + 1 < headings.size() ? k + 1 : k].second;
+    }
+
+    size_t n = nodes.size();
+    if (n < 2)
+        return trajectory;
+
+    // How x, y and heading change per inch along the path, from the neighbouring nodes
+    for (size_t i = 0; i < n; i++) {
+        const Node &a = nodes[i == 0 ? 0 : i - 1], &b = nodes[i + 1 == n ? i : i + 1];
+        double ds = b.distance - a.distance;
+        nodes[i].dx = (b.x - a.x) / ds;
+        nodes[i].dy = (b.y - a.y) / ds;
+        nodes[i].dHeading = (b.heading - a.heading) / ds;
+    }
+
+    // Wheel rates at each node, and how they change per inch over each interval between two nodes
+    std::vector<Eigen::Vector4d> rates(n), rateChanges(n - 1);
+    for (size_t i = 0; i < n; i++)
+        rates[i] = wheelRates(nodes[i].dx, nodes[i].dy, nodes[i].dHeading, nodes[i].heading, inverseKinematics);
+    for (size_t i = 0; i + 1 < n; i++)
+        rateChanges[i] = (rates[i + 1] - rates[i]) / (nodes[i + 1].distance - nodes[i].distance);
+
+    // Fastest path speed at each node: no wheel above its top speed, and the part of the wheel acceleration that
+    // comes from the path bending or the heading blending changing (rate change * speed²) within the limit,
+    // over the intervals on both sides
+    std::vector<double> limit(n);
+    for (size_t i = 0; i < n; i++) {
+        limit[i] = INFINITY;
+        for (int w = 0; w < 4; w++) {
+            if (std::fabs(rates[i](w)) > 1e-9)
+                limit[i] = std::min(limit[i], constraints.maxWheelVelocity / std::fabs(rates[i](w)));
+            for (size_t j = i == 0 ? 0 : i - 1; j <= i && j + 1 < n; j++)
+                if (std::fabs(rateChanges[j](w)) > 1e-9)
+                    limit[i] = std::min(limit[i], std::sqrt(constraints.maxWheelAcceleration / std::fabs(rateChanges[j](w))));
+        }
+    }
+
+    // Checks the constant path acceleration over an interval against the wheels at both of its ends, given the squared
+    // speeds there. Checking only the end the pass starts from let the other end go over the limit
+    const double tolerance = constraints.maxWheelAcceleration * 1e-6;
+    auto intervalFits = [&](size_t i, double speed2Before, double speed2After, bool checkLow, bool checkHigh) {
+        double ds = nodes[i + 1].distance - nodes[i].distance;
+        double acceleration = (speed2After - speed2Before) / (2 * ds);
+        double low, high;
+        for (size_t node = i; node <= i + 1; node++) {
+            accelerationRange(rates[node], rateChanges[i], node == i ? speed2Before : speed2After,
+                              constraints.maxWheelAcceleration, low, high);
+            if ((checkLow && acceleration < low - tolerance) || (checkHigh && acceleration > high + tolerance))
+                return false;
+        }
+        return true;
+    };
+    // Largest squared speed up to high that fits, by bisection. Standing still always fits, as the speeds below the
+    // node limits keep the curvature part of the wheel acceleration within the limit
+    auto largestSpeed2 = [](double high, const auto &fits) {
+        if (fits(high))
+            return high;
+        double low = 0;
+        for (int k = 0; k < 40; k++) {
+            double mid = (low + high) / 2;
+            (fits(mid) ? low : high) = mid;
+        }
+        return low;
+    };
+
+    // Forward pass speeds up as hard as the wheels allow, backward pass makes sure the robot can slow down in time.
+    // Lowering a node's speed in one pass can change what the interval before it allows, so both run again until
+    // every interval fits
+    for (size_t i = 0; i < n; i++)
+        nodes[i].speed = limit[i];
+    nodes[0].speed = nodes[n - 1].speed = 0;
+    for (int iteration = 0; iteration < TRAJECTORY_MAX_PASSES; iteration++) {
+        for (size_t i = 0; i + 1 < n; i++) {
+            double before = nodes[i].speed * nodes[i].speed;
+            nodes[i + 1].speed = std::sqrt(largestSpeed2(nodes[i + 1].speed * nodes[i + 1].speed, [&](double after) {
+                return intervalFits(i, before, after, false, true);
+            }));
+        }
+        for (size_t i = n - 1; i > 0; i--) {
+            double after = nodes[i].speed * nodes[i].speed;
+            nodes[i - 1].speed = std::sqrt(largestSpeed2(nodes[i - 1].speed * nodes[i - 1].speed, [&](double before) {
+                return intervalFits(i - 1, before, after, true, false);
+            }));
+        }
+
+        bool consistent = true;
+        for (size_t i = 0; i + 1 < n && consistent; i++)
+            consistent = intervalFits(i, nodes[i].speed * nodes[i].speed, nodes[i + 1].speed * nodes[i + 1].speed,
+                                      true, true);
+        if (consistent)
+            break;
+    }
+
+    // Constant acceleration between nodes
+    for (size_t i = 1; i < n; i++) {
+        double ds = nodes[i].distance - nodes[i - 1].distance;
+        nodes[i].time = nodes[i - 1].time + 2 * ds / (nodes[i].speed + nodes[i - 1].speed);
+    }
+    return trajectory;
+}
+
+util::TrajectoryState util::Trajectory::sample(double time) const {
+    auto it = std::upper_bound(nodes.begin(), nodes.end(), time,
+                               [](double t, const Node &node) { return t < node.time; });
+    if (it == nodes.begin() || it == nodes.end()) {
+        const Node &node = it == nodes.begin() ? nodes.front() : nodes.back();
+        return {{node.x, node.y, node.heading}, {0, 0, 0}};
+    }
+
+    const Node &a = *(it - 1), &b = *it;
+    double t = (time - a.time) / (b.time - a.time);
+    auto lerp = [t](double from, double to) { return from + t * (to - from); };
+    double speed = lerp(a.speed, b.speed);
+    return {{lerp(a.x, b.x), lerp(a.y, b.y), lerp(a.heading, b.heading)},
+            {lerp(a.dx, b.dx) * speed, lerp(a.dy, b.dy) * speed, lerp(a.dHeading, b.dHeading) * speed}};
+}
+
+double util::Trajectory::duration() const {
+    return nodes.back().time;
+}
+
+double util::Trajectory::length() const {
+    return nodes.back().distance;
+}
+
+util::ChassisPos util::Trajectory::end() const {
+    return {nodes.back().x, nodes.back().y, nodes.back().heading};
+}
@@ -0,0 +1,90 @@
+#ifndef _TRAJECTORY_HPP_INCLUDED
+#define _TRAJECTORY_HPP_INCLUDED
+
+#include <optional>
+#include <vector>
+#include "Eigen/Core"
+#include "profiles.hpp"
+#include "util/struct.hpp"
+
+namespace util {
+    /// A point a trajectory passes through, optionally with the heading the robot should have there.
+    struct TrajectoryWaypoint {
+        double x, y;                   // Inches
+        std::optional<double> heading; // Radians. Without one, the heading keeps turning towards the next one given
+    };
+
+    /// Limits a trajectory is planned within. Defaults come from profiles.hpp
+    struct TrajectoryConstraints {
+        double maxWheelVelocity = TRAJECTORY_MAX_WHEEL_SPEED_IN_S;      // Inches per second, for every wheel
+        double maxWheelAcceleration = TRAJECTORY_MAX_WHEEL_ACCEL_IN_S2; // Inches per second squared, for every wheel
+        double spacing = TRAJECTORY_SPACING_IN; // Distance between the planned points, in inches
+    };
+
+    /// Where a trajectory wants the robot to be at one point in time.
+    struct TrajectoryState {
+        ChassisPos pos;   // Field position, angle in radians
+        ChassisSpeed vel; // Field velocity in inches and radians per second
+    };
+
+    /**
+     * A time parameterized path for the X-drive that moves and turns at the same time.
+     *
+     * The waypoints are joined with a Catmull-Rom spline and the heading is blended along it.
+     * The speed along the path is planned with a forward and a backward pass, so that every wheel stays within its
+     * velocity and acceleration limits through the inverse kinematics matrix. The robot goes as fast as the wheel that's
+     * working the hardest allows, instead of scaling every wheel down after the fact like WheelSpeed::normalize.
+     *
+     * Planning allocates and should be done before the move. Sampling is a binary search and doesn't allocate.
+     * Free of PROS calls so it can be planned and checked off the robot.
+     */
+    class Trajectory {
+    public:
+        /// An empty trajectory that stays at the origin.
+        Trajectory();
+
+        /**
+         * Plans a trajectory from a stop to a stop.
+         *
+         * \param start Where the robot starts, angle in radians.
+         *
+         * \param waypoints The points to pass through after the start. The last one is where the robot stops.
+         *
+         * \param inverseKinematics Wheel speeds from (forward, left, counterclockwise) chassis speeds,
+         * from InverseKinematics::getMatrix().
+         *
+         * \param constraints The wheel limits.
+         */
+        static Trajectory plan(ChassisPos start, const std::vector<TrajectoryWaypoint> &waypoints,
+                               const Eigen::Matrix<double, 4, 3> &inverseKinematics,
+                               TrajectoryConstraints constraints = TrajectoryConstraints());
+
+        /**
+         * Finds where the trajectory is at a point in time.
+         *
+         * \param time Seconds since the start. Holds the start or end position outside of the trajectory.
+         */
+        TrajectoryState sample(double time) const;
+
+        /// \return How long the trajectory takes in seconds.
+        double duration() const;
+
+        /// \return The length of the path in inches.
+        double length() const;
+
+        /// \return Where the trajectory ends.
+        ChassisPos end() const;
+
+    private:
+        // One planned point along the path
+        struct Node {
+            double time;     // Seconds from the start
+            double distance; // Inches along the path
+            double x, y, heading;
+            double dx, dy, dHeading; // Change per inch along the path
+            double speed;            // Inches per second along the path
+        };
+        std::vector<Node> nodes;
+    };
+}
+#endif /* _TRAJECTORY_HPP_INCLUDED */
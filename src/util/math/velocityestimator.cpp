@@ -0,0 +1,116 @@
+#include "velocityestimator.hpp"
+
+#include <cmath>
+#include "Eigen/Core"
+#include "Eigen/Cholesky"
+
+util::VelocityEstimator::VelocityEstimator(Filter filter) : filter(filter) {
+    reset({0, 0, 0}, 0);
+}
+
+void util::VelocityEstimator::reset(ChassisPos pos, uint64_t timestamp) {
+    window[0] = {timestamp / 1e6, pos.x, pos.y, pos.angle};
+    count = 1;
+    newest = 0;
+    angle = pos.angle;
+    for (int i = 0; i < 3; i++)
+        vel[i] = accel[i] = lastRaw[i] = lastVel[i] = 0;
+}
+
+void util::VelocityEstimator::update(ChassisPos pos, uint64_t timestamp) {
+    Entry &last = window[newest];
+    double t = timestamp / 1e6;
+    double dt = t - last.t;
+    if (dt <= 0)
+        return;
+
+    double raw[3] = {(pos.x - last.x) / dt, (pos.y - last.y) / dt, (pos.angle - last.angle) / dt};
+    newest = (newest + 1) % ODOM_VEL_MAX_SAMPLES;
+    window[newest] = {t, pos.x, pos.y, pos.angle};
+    if (count < ODOM_VEL_MAX_SAMPLES)
+        count++;
+    angle = pos.angle;
+
+    switch (filter) {
+        case VEL_MATH:
+            // Average of the last two differences, like okapi's default VelMath filter
+            for (int i = 0; i < 3; i++) {
+                double v = (raw[i] + lastRaw[i]) / 2.0;
+                accel[i] = (v - vel[i]) / dt;
+                vel[i] = v;
+                lastRaw[i] = raw[i];
+            }
+            break;
+        case EMA: {
+            // Weighting from the real time step, so a late cycle counts for more instead of looking like a spike
+            double alpha = 1 - std::exp(-dt / ODOM_VEL_EMA_TIME_S);
+            for (int i = 0; i < 3; i++) {
+                vel[i] += alpha * (raw[i] - vel[i]);
+                accel[i] += alpha * ((vel[i] - lastVel[i]) / dt - accel[i]);
+                lastVel[i] = vel[i];
+            }
+            break;
+        }
+        case SAVITZKY_GOLAY:
+            fitWindow();
+            break;
+    }
+}
+
+void util::VelocityEstimator::fitWindow() {
+    // Only the positions within the time window, newest first, so the lag doesn't depend on how often odometry steps
+    const Entry &now = window[newest];
+    int used = 0;
+    while (used < count && now.t - window[(newest + ODOM_VEL_MAX_SAMPLES - used) % ODOM_VEL_MAX_SAMPLES].t <= ODOM_VEL_WINDOW_S)
+        used++;
+
+    if (used < 3) {
+        // Not enough points for a quadratic, fall back to a straight line between the last two
+        const Entry &a = window[(newest + ODOM_VEL_MAX_SAMPLES - 1) % ODOM_VEL_MAX_SAMPLES], &b = window[newest];
+        double dt = b.t - a.t;
+        vel[0] = (b.x - a.x) / dt;
+        vel[1] = (b.y - a.y) / dt;
+        vel[2] = (b.angle - a.angle) / dt;
+        return;
+    }
+
+    // Least squares fit of p(t) = c0 + c1 t + c2 t², with t relative to the newest sample so c1 is the velocity now.
+    // t is in milliseconds to keep the normal equations well conditioned. They are shared by all three axes
+    Eigen::Matrix3d normal = Eigen::Matrix3d::Zero();
+    Eigen::Matrix3d rhs = Eigen::Matrix3d::Zero(); // One column per axis
+    for (int i = 0; i < used; i++) {
+        const Entry &e = window[(newest + ODOM_VEL_MAX_SAMPLES - i) % ODOM_VEL_MAX_SAMPLES];
+        double t = (e.t - now.t) * 1000;
+        Eigen::Vector3d basis(1, t, t * t);
+        normal += basis * basis.transpose();
+        rhs.col(0) += basis * (e.x - now.x);
+        rhs.col(1) += basis * (e.y - now.y);
+        rhs.col(2) += basis * (e.angle - now.angle);
+    }
+    Eigen::Matrix3d coefficients = normal.ldlt().solve(rhs);
+    for (int i = 0; i < 3; i++) {
+        vel[i] = coefficients(1, i) * 1e3;
+        accel[i] = 2 * coefficients(2, i) * 1e6;
+    }
+}
+
+util::ChassisSpeed util::VelocityEstimator::toRobot(const double field[3]) {
+    double s = std::sin(angle), c = std::cos(angle);
+    return {field[0] * c - field[1] * s, field[0] * s + field[1] * c, field[2]};
+}
+
+util::ChassisSpeed util::VelocityEstimator::getFieldVel() {
+    return {vel[0], vel[1], vel[2]};
+}
+
+util::ChassisSpeed util::VelocityEstimator::getFieldAccel() {
+    return {accel[0], accel[1], accel[2]};
+}
+
+util::ChassisSpeed util::VelocityEstimator::getRobotVel() {
+    return toRobot(vel);
+}
+
+util::ChassisSpeed util::VelocityEstimator::getRobotAccel() {
+    return toRobot(accel);
+}
@@ -0,0 +1,78 @@
+#ifndef _VELOCITYESTIMATOR_HPP_INCLUDED
+#define _VELOCITYESTIMATOR_HPP_INCLUDED
+
+#include <cstdint>
+#include "profiles.hpp"
+#include "util/struct.hpp"
+
+namespace util {
+    /**
+     * Estimates the velocity and acceleration of the chassis from timestamped field positions.
+     *
+     * Uses the real time between positions instead of assuming the loop ran on time, and filters out the noise from
+     * encoders moving in whole ticks. Everything is fixed size, so updating never allocates.
+     * Doesn't use any PROS calls.
+     */
+    class VelocityEstimator {
+    public:
+        enum Filter {
+            VEL_MATH,      // Finite difference averaged over the last few samples, the same math as okapi's VelMath
+            EMA,           // Exponential moving average of the finite difference, with a time constant
+            SAVITZKY_GOLAY // Quadratic least squares fit over the last ODOM_VEL_WINDOW_S seconds, at the real timestamps
+        };
+
+        VelocityEstimator(Filter filter = ODOM_VEL_FILTER);
+
+        /**
+         * Forgets all previous positions.
+         *
+         * \param pos The current position, angle in radians.
+         *
+         * \param timestamp The time of the position in microseconds.
+         */
+        void reset(ChassisPos pos, uint64_t timestamp);
+
+        /**
+         * Adds a new position. Positions with the same or an older timestamp than the last one are ignored.
+         *
+         * \param pos The current position, angle in radians. The angle must not wrap around.
+         *
+         * \param timestamp The time of the position in microseconds.
+         */
+        void update(ChassisPos pos, uint64_t timestamp);
+
+        /// \return The velocity along the field's x and y, in inches per second, and the turn rate in radians per second.
+        ChassisSpeed getFieldVel();
+
+        /// \return The acceleration along the field's x and y in inches per second squared, angle in radians per second squared.
+        ChassisSpeed getFieldAccel();
+
+        /// \return The velocity to the robot's right (x) and forward (y), in inches per second, and the turn rate.
+        ChassisSpeed getRobotVel();
+
+        /// \return The field acceleration turned into the robot's right (x) and forward (y) directions.
+        ChassisSpeed getRobotAccel();
+
+    private:
+        struct Entry {
+            double t; // Seconds
+            double x, y, angle;
+        };
+
+        Filter filter;
+        Entry window[ODOM_VEL_MAX_SAMPLES];
+        int count = 0, newest = -1;
+        double angle = 0;
+        double vel[3] = {0, 0, 0}, accel[3] = {0, 0, 0};
+        // VEL_MATH keeps the last finite differences, EMA the last filtered velocity
+        double lastRaw[3] = {0, 0, 0}, lastVel[3] = {0, 0, 0};
+
+        /// Fits a quadratic through the positions from the last ODOM_VEL_WINDOW_S seconds
+        /// and sets vel and accel from its slope and curvature at the newest sample.
+        void fitWindow();
+
+        /// Turns a field vector into the robot's right and forward directions.
+        ChassisSpeed toRobot(const double field[3]);
+    };
+}
+#endif /* _VELOCITYESTIMATOR_HPP_INCLUDED */
@@ -0,0 +1,85 @@
+#include "path.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+util::Path::Path() : Path(std::vector<Pos2d>{Pos2d()}) {
+}
+
+util::Path::Path(std::vector<Pos2d> waypoints) : points(waypoints) {
+    size_t n = points.size();
+    arcLength.resize(n, 0);
+    curvature.resize(n, 0);
+
+    for (size_t i = 1; i < n; i++)
+        arcLength[i] = arcLength[i - 1] + points[i].distance(points[i - 1]);
+
+    // Curvature of the circle through three neighbouring points is 4 * triangle area / product of the sides.
+    // The ends have no neighbour on one side and are treated as straight
+    for (size_t i = 1; i + 1 < n; i++) {
+        Pos2d &a = points[i - 1], &b = points[i], &c = points[i + 1];
+        double cross = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        double sides = a.distance(b) * b.distance(c) * c.distance(a);
+        curvature[i] = sides < 1e-9 ? 0 : std::fabs(2 * cross) / sides;
+    }
+}
+
+double util::Path::length() const {
+    return arcLength.back();
+}
+
+util::Pos2d util::Path::end() const {
+    return points.back();
+}
+
+size_t util::Path::segmentAt(double s) const {
+    if (points.size() < 2)
+        return 0;
+    // First point further along than s, the segment starts one before it
+    size_t i = std::upper_bound(arcLength.begin(), arcLength.end(), s) - arcLength.begin();
+    return std::clamp(i, (size_t)1, points.size() - 1) - 1;
+}
+
+util::Pos2d util::Path::pointAt(double s) const {
+    if (points.size() < 2)
+        return points[0];
+    s = std::clamp(s, 0.0, length());
+    size_t i = segmentAt(s);
+    double segmentLength = arcLength[i + 1] - arcLength[i];
+    double t = segmentLength < 1e-9 ? 0 : (s - arcLength[i]) / segmentLength;
+    return {points[i].x + (points[i + 1].x - points[i].x) * t, points[i].y + (points[i + 1].y - points[i].y) * t};
+}
+
+double util::Path::curvatureAt(double s) const {
+    if (points.size() < 2)
+        return 0;
+    s = std::clamp(s, 0.0, length());
+    size_t i = segmentAt(s);
+    double segmentLength = arcLength[i + 1] - arcLength[i];
+    double t = segmentLength < 1e-9 ? 0 : (s - arcLength[i]) / segmentLength;
+    return curvature[i] + (curvature[i + 1] - curvature[i]) * t;
+}
+
+double util::Path::closestArcLength(Pos2d pos, double from, double window) const {
+    if (points.size() < 2)
+        return 0;
+    from = std::clamp(from, 0.0, length());
+    double best = from, bestDistance = pos.distance(pointAt(from).x, pointAt(from).y);
+    for (size_t i = segmentAt(from); i + 1 < points.size() && arcLength[i] <= from + window; i++) {
+        // Project onto the segment, clamped to its ends
+        Pos2d a = points[i], b = points[i + 1];
+        double dx = b.x - a.x, dy = b.y - a.y;
+        double segmentLength = arcLength[i + 1] - arcLength[i];
+        if (segmentLength < 1e-9)
+            continue;
+        double t = std::clamp(((pos.x - a.x) * dx + (pos.y - a.y) * dy) / (segmentLength * segmentLength), 0.0, 1.0);
+        double s = std::clamp(arcLength[i] + t * segmentLength, from, from + window);
+        Pos2d p = pointAt(s);
+        double d = pos.distance(p.x, p.y);
+        if (d < bestDistance) {
+            bestDistance = d;
+            best = s;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,68 @@
+#ifndef _UTIL_PATH_HPP_INCLUDED
+#define _UTIL_PATH_HPP_INCLUDED
+
+#include <cstddef>
+#include <vector>
+#include "util/struct.hpp"
+
+namespace util {
+    /**
+     * A polyline through a list of waypoints, with its arc length and curvature worked out once up front
+     * so following it only needs cheap lookups.
+     *
+     * Positions along the path are given as arc length, in inches from the first waypoint.
+     */
+    class Path {
+    public:
+        Path();
+
+        /// \param waypoints The points to go through, in order. Needs at least one.
+        Path(std::vector<Pos2d> waypoints);
+
+        /// \return The total length of the path in inches.
+        double length() const;
+
+        /// \return The last waypoint.
+        Pos2d end() const;
+
+        /**
+         * Finds the point a certain distance along the path.
+         *
+         * \param s Arc length in inches. Clamped to the ends of the path.
+         */
+        Pos2d pointAt(double s) const;
+
+        /**
+         * \param s Arc length in inches.
+         *
+         * \return The curvature of the path there, in 1/inches. Always positive, 0 on a straight line.
+         */
+        double curvatureAt(double s) const;
+
+        /**
+         * Finds the point on the path closest to a position.
+         * Only looks forward from where the robot was last, so the robot can't skip back to a part of the path
+         * that happens to pass close by.
+         *
+         * \param pos The position to project onto the path.
+         *
+         * \param from Arc length the robot was at last time, in inches.
+         *
+         * \param window How far ahead of from to look, in inches.
+         *
+         * \return Arc length of the closest point, in inches. Never less than from.
+         */
+        double closestArcLength(Pos2d pos, double from, double window) const;
+
+    private:
+        std::vector<Pos2d> points;
+        /// Arc length at each point
+        std::vector<double> arcLength;
+        /// Curvature at each point, from the circle through it and its neighbours
+        std::vector<double> curvature;
+
+        /// \return The index of the segment that contains arc length s, found with a binary search.
+        size_t segmentAt(double s) const;
+    };
+}
+#endif /* _UTIL_PATH_HPP_INCLUDED */
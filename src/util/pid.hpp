@@ -0,0 +1,176 @@
+#ifndef _UTIL_PID_HPP_INCLUDED
+#define _UTIL_PID_HPP_INCLUDED
+
+#include <algorithm>
+#include <cmath>
+
+namespace util {
+    /// Parts of a Pid that can be turned on or off when it's built. Combined with |
+    enum PidFeature : unsigned {
+        PID_INTEGRAL_CLAMP = 1 << 0,            // Keeps the integral within the integral limits
+        PID_DERIVATIVE_ON_MEASUREMENT = 1 << 1, // Derivative of the reading instead of the error, no kick on a new target
+        PID_OUTPUT_LIMIT = 1 << 2,              // Keeps the output within the output limits
+        PID_SETTLING = 1 << 3,                  // Tracks how long the error has been small, for isSettled()
+        PID_MEASURED_DT = 1 << 4,               // step() takes the real time since the last step instead of assuming it
+        PID_RESET_ON_ZERO_CROSSING = 1 << 5,    // Forgets the integral when the error changes sign
+
+        // Behaves like okapi's IterativePosPIDController with its default settings
+        PID_OKAPI = PID_INTEGRAL_CLAMP | PID_DERIVATIVE_ON_MEASUREMENT | PID_OUTPUT_LIMIT | PID_SETTLING |
+                    PID_RESET_ON_ZERO_CROSSING
+    };
+
+    /**
+     * Positional PID controller for control loops.
+     *
+     * Header only, never allocates and has no virtual calls or PROS calls, so it can be stepped from any task
+     * and benchmarked off the robot. Features are picked at compile time, so the ones left out cost nothing.
+     *
+     * Gains use okapi's units: kI and kD are per second and scaled by the sample time, so with PID_OKAPI this gives
+     * the same output as okapi::IterativeControllerFactory::posPID stepped on the same schedule.
+     *
+     * \tparam T The number type, double or float.
+     *
+     * \tparam Features The PidFeature flags to build with.
+     */
+    template <typename T = double, unsigned Features = PID_OKAPI>
+    class Pid {
+    public:
+        /**
+         * \param kP Proportional gain.
+         *
+         * \param kI Integral gain.
+         *
+         * \param kD Derivative gain.
+         *
+         * \param sampleTime Seconds between steps. Used as the time step unless built with PID_MEASURED_DT.
+         */
+        Pid(T kP, T kI, T kD, T sampleTime = T(0.01)) : kP(kP), kI(kI), kD(kD), sampleTime(sampleTime) {
+        }
+
+        /**
+         * Steps the controller by one sample time. Only available without PID_MEASURED_DT.
+         *
+         * \param reading The new reading of the value being controlled.
+         *
+         * \return The new output.
+         */
+        T step(T reading) {
+            static_assert(!(Features & PID_MEASURED_DT), "Built with PID_MEASURED_DT, pass the time since the last step");
+            return update(reading, sampleTime);
+        }
+
+        /**
+         * Steps the controller by the real time since the last step. Only available with PID_MEASURED_DT.
+         *
+         * \param reading The new reading of the value being controlled.
+         *
+         * \param dt Seconds since the last step. Steps that take no time keep the last output.
+         *
+         * \return The new output.
+         */
+        T step(T reading, T dt) {
+            static_assert(Features & PID_MEASURED_DT, "Built without PID_MEASURED_DT, the time step is fixed");
+            if (dt <= 0)
+                return output;
+            return update(reading, dt);
+        }
+
+        /// Sets the value the controller drives the reading towards.
+        void setTarget(T newTarget) {
+            target = newTarget;
+        }
+
+        /// \return The target.
+        T getTarget() const {
+            return target;
+        }
+
+        /// \return The output of the last step.
+        T getOutput() const {
+            return output;
+        }
+
+        /// \return The error of the last step, target - reading.
+        T getError() const {
+            return error;
+        }
+
+        /// Sets the range the output is kept within with PID_OUTPUT_LIMIT. Defaults to -1 to 1 like okapi.
+        void setOutputLimits(T min, T max) {
+            outputMin = min;
+            outputMax = max;
+        }
+
+        /// Sets the range the integral term is kept within with PID_INTEGRAL_CLAMP. Defaults to -1 to 1 like okapi.
+        void setIntegralLimits(T min, T max) {
+            integralMin = min;
+            integralMax = max;
+        }
+
+        /**
+         * Sets when the controller counts as settled with PID_SETTLING. Defaults to okapi's SettledUtil values.
+         *
+         * \param error How small the error has to be.
+         *
+         * \param derivative How little the error can change from one step to the next.
+         *
+         * \param time How long, in seconds, both have to hold.
+         */
+        void setSettle(T error, T derivative, T time) {
+            settleError = error;
+            settleDerivative = derivative;
+            settleTime = time;
+        }
+
+        /// \return True if the error has been small and steady for long enough. Always false without PID_SETTLING.
+        bool isSettled() const {
+            return (Features & PID_SETTLING) && settledFor >= settleTime;
+        }
+
+        /// Clears the integral, the last reading and the output. Keeps the target, gains and limits.
+        void reset() {
+            error = lastError = lastReading = integral = output = settledFor = 0;
+            atTarget = false;
+        }
+
+    private:
+        T kP, kI, kD, sampleTime;
+        T target = 0, error = 0, lastError = 0, lastReading = 0, integral = 0, output = 0;
+        T outputMin = -1, outputMax = 1, integralMin = -1, integralMax = 1;
+        T settleError = 50, settleDerivative = 5, settleTime = T(0.25), settledFor = 0;
+        bool atTarget = false;
+
+        T update(T reading, T dt) {
+            error = target - reading;
+
+            integral += kI * dt * error;
+            if constexpr ((Features & PID_RESET_ON_ZERO_CROSSING) != 0)
+                if (std::signbit(error) != std::signbit(lastError))
+                    integral = 0;
+            if constexpr ((Features & PID_INTEGRAL_CLAMP) != 0)
+                integral = std::clamp(integral, integralMin, integralMax);
+
+            T derivative;
+            if constexpr ((Features & PID_DERIVATIVE_ON_MEASUREMENT) != 0)
+                derivative = -(reading - lastReading) / dt;
+            else
+                derivative = (error - lastError) / dt;
+
+            output = kP * error + integral + kD * derivative;
+            if constexpr ((Features & PID_OUTPUT_LIMIT) != 0)
+                output = std::clamp(output, outputMin, outputMax);
+
+            if constexpr ((Features & PID_SETTLING) != 0) {
+                // Counts from the first step at the target, like SettledUtil's timer
+                bool nowAtTarget = std::abs(error) <= settleError && std::abs(error - lastError) <= settleDerivative;
+                settledFor = nowAtTarget && atTarget ? settledFor + dt : 0;
+                atTarget = nowAtTarget;
+            }
+
+            lastReading = reading;
+            lastError = error;
+            return output;
+        }
+    };
+}
+#endif /* _UTIL_PID_HPP_INCLUDED */
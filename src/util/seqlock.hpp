@@ -0,0 +1,89 @@
+#ifndef _UTIL_SEQLOCK_HPP_INCLUDED
+#define _UTIL_SEQLOCK_HPP_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+// Define SEQLOCK_NO_PROS to build it off the robot, like tools/seqlockstress.cpp does
+#ifdef SEQLOCK_NO_PROS
+#include <thread>
+#else
+#include "api.h"
+#endif
+
+namespace util {
+    /**
+     * Single writer, multiple reader sequence lock.
+     *
+     * The writer never blocks. Readers copy the data out and retry if the writer touched it in the meantime,
+     * so every read returns one consistent value instead of a half-updated one.
+     *
+     * T should be a small struct that only holds values. A reader can copy it while the writer is half way through,
+     * and throws that copy away, so the copy must not follow pointers or own memory. Trivially copyable structs are
+     * fine. Fixed size Eigen matrices, like the covariance in PoseSnapshot, aren't trivially copyable on paper, but
+     * their copy only copies the elements in place, so a torn one is just as harmless.
+     * Anything that allocates, like std::vector or std::string, is caught by the static_assert.
+     * tools/seqlockstress.cpp checks both kinds for torn reads.
+     */
+    template <typename T>
+    class SeqLock {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "SeqLock can only hold plain values, a torn copy of T would be destroyed");
+
+    private:
+        /// Odd while a write is in progress, incremented twice per write.
+        std::atomic<uint32_t> sequence{0};
+        /// Number of times a reader had to throw away a copy and read again.
+        std::atomic<uint32_t> retries{0};
+        T data{};
+
+    public:
+        /**
+         * Publishes a new value. Must only be called from a single task at a time.
+         *
+         * \param value The value to publish.
+         */
+        void write(const T &value) {
+            uint32_t seq = sequence.load(std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            data = value;
+            std::atomic_thread_fence(std::memory_order_release);
+            sequence.store(seq + 2, std::memory_order_relaxed);
+        }
+
+        /**
+         * Reads a consistent copy of the last published value.
+         *
+         * \return The last value passed to write().
+         */
+        T read() {
+            T copy;
+            while (true) {
+                uint32_t before = sequence.load(std::memory_order_acquire);
+                if (!(before & 1)) {
+                    copy = data;
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (sequence.load(std::memory_order_relaxed) == before)
+                        return copy;
+                }
+                retries.fetch_add(1, std::memory_order_relaxed);
+                // The V5 only has one core to run user code on, so an odd sequence means the writer got preempted
+                // half way through. Sleep so it gets a chance to finish instead of spinning until the next tick.
+                if (before & 1) {
+#ifdef SEQLOCK_NO_PROS
+                    std::this_thread::yield();
+#else
+                    pros::delay(1);
+#endif
+                }
+            }
+        }
+
+        /// \return The number of times a reader had to retry because the writer was active. Used to gauge contention.
+        uint32_t getRetryCount() {
+            return retries.load(std::memory_order_relaxed);
+        }
+    };
+}
+#endif /* _UTIL_SEQLOCK_HPP_INCLUDED */
@@ -2,6 +2,7 @@
 #include <algorithm>
 #include "profiles.hpp"
 #include "io.hpp"
+#include "util/completion.hpp"
 
 util::SlewRateLimiter::SlewRateLimiter(double rateLimit, double initValue, double rateOnDecel){
     this->ratelimit = rateLimit;
@@ -35,6 +36,11 @@ bool util::runAsBlocking(std::function<void()> fn, std::function<bool()> conditi
     return blocking(condition, timeout, pollRate);
 }
 
+bool util::runAsBlocking(std::function<void()> fn, Completion &completion, int timeoutMs) {
+    fn();
+    return completion.wait(timeoutMs);
+}
+
 bool util::blocking(std::function<bool()> condition) {
     return blocking(condition, NO_TIME_OUT, BLOCKING_DEFAULT_POLL_RATE);
 }
@@ -23,7 +23,11 @@
 #define BLOCKING_DEFAULT_POLL_RATE 30
 #define NO_TIME_OUT -1
 
+// Provided by the V5 runtime that PROS links against. This PROS version doesn't wrap it yet.
+extern "C" uint64_t vexSystemHighResTimeGet(void);
+
 namespace util {
+    class Completion;
 
     /** 
      * Helps in limitting the rate of change of a certain value.
@@ -69,6 +73,11 @@ namespace util {
         void reset(double newValue);
     };
 
+    ///Returns the time since the program started in microseconds.
+    inline uint64_t micros() {
+        return vexSystemHighResTimeGet();
+    };
+
     ///Returns the average of 2 double numbers
     inline double avgDouble(double a, double b) {
         return (a + b) / 2.0;
@@ -111,6 +120,17 @@ namespace util {
      */
     bool runAsBlocking(std::function<void()> fn, std::function<bool()> condition);
 
+    /**
+     * Runs an asynchronous function as blocking, waking up as soon as the subsystem it started signals it's done
+     * instead of polling.
+     * \param fn the asynchronous function to run.
+     * 
+     * \param completion The Completion the subsystem finishes when its work is done, e.g. AutoDrive::completion().
+     * 
+     * \param timeoutMs A timeout amount in milliseconds. Stops blocking after a certain amount of time.
+     */
+    bool runAsBlocking(std::function<void()> fn, Completion &completion, int timeoutMs = NO_TIME_OUT);
+
     /**
      * Blocks the current task until a condition function returns true.
      * 
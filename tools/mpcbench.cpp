@@ -0,0 +1,184 @@
+// Tracks the skills routine's moves as trajectories (see trajectory.hpp) on a simulated X-drive, once with the PID
+// controllers the way AutoDrive does and once with the model predictive controller (see mpc.hpp).
+// Reports how long a solve takes and how far the robot strays from the trajectory with each.
+//
+// The simulated wheels follow their commanded speed with a little lag and can't go past full speed. The timings are
+// from the machine this runs on; the V5's Cortex-A9 is several times slower, so leave plenty of room under 10ms.
+//
+// Build from the root of the repo:
+//   g++ -std=gnu++17 -O2 -Isrc -isystem /usr/include/eigen3 tools/mpcbench.cpp src/util/math/mpc.cpp src/util/math/trajectory.cpp -o mpcbench
+//
+// Usage:
+//   ./mpcbench [--wheel-speed fraction of full speed] [--lag s] [--verbose]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "Eigen/LU"
+#include "profiles.hpp"
+#include "skillsroutine.hpp"
+#include "util/pid.hpp"
+#include "util/math/mpc.hpp"
+#include "util/math/trajectory.hpp"
+
+namespace {
+    double wrap(double angle) {
+        return std::remainder(angle, 2 * M_PI);
+    }
+
+    // An X-drive whose wheels reach their commanded speed with a first order lag, capped at full speed
+    struct Robot {
+        util::ChassisPos pos;
+        Eigen::Vector4d wheels = Eigen::Vector4d::Zero(); // lf, rf, lr, rr like the matrix rows
+        Eigen::Matrix<double, 3, 4> forwardKinematics;
+        double lag;
+
+        Robot(util::ChassisPos pos, const Eigen::Matrix<double, 4, 3> &ik, double lag) : pos(pos), lag(lag) {
+            forwardKinematics = (ik.transpose() * ik).inverse() * ik.transpose();
+        }
+
+        void update(const Eigen::Vector4d &command, double dt) {
+            const int substeps = 10;
+            double h = dt / substeps;
+            Eigen::Vector4d target = command.cwiseMax(-MAX_SPEED_IN_S).cwiseMin(MAX_SPEED_IN_S);
+            for (int i = 0; i < substeps; i++) {
+                wheels += (target - wheels) * (1 - std::exp(-h / lag));
+                Eigen::Vector3d chassis = forwardKinematics * wheels; // forward, left, counterclockwise
+                double s = std::sin(pos.angle), c = std::cos(pos.angle);
+                pos.x += (chassis(0) * s - chassis(1) * c) * h;
+                pos.y += (chassis(0) * c + chassis(1) * s) * h;
+                pos.angle -= chassis(2) * h;
+            }
+        }
+    };
+
+    // AutoDrive's profiled trajectory branch: PID on the error to the reference, plus its velocity, through IK
+    struct PidTracker {
+        util::Pid<> power{FORWARD_P, FORWARD_I / 2.0, FORWARD_D * 2.0};
+        util::Pid<> strafe{STRAFE_P, STRAFE_I / 2.0, STRAFE_D * 2.0};
+        util::Pid<> turn{TURNING_P, TURNING_I / 2.0, TURNING_D * 2.0};
+        Eigen::Matrix<double, 4, 3> ik;
+
+        Eigen::Vector4d step(const util::ChassisPos &pos, const util::TrajectoryState &ref) {
+            double dx = ref.pos.x - pos.x, dy = ref.pos.y - pos.y;
+            double distance = std::hypot(dx, dy), angleTo = wrap(std::atan2(dx, dy) - pos.angle);
+            turn.step(-wrap(ref.pos.angle - pos.angle));
+            power.step(-distance * std::cos(angleTo));
+            strafe.step(-distance * std::sin(angleTo));
+
+            double s = std::sin(pos.angle), c = std::cos(pos.angle);
+            double forward = power.getOutput() * MAX_SPEED_IN_S * M_SQRT2 + ref.vel.x * s + ref.vel.y * c;
+            double right = strafe.getOutput() * MAX_SPEED_IN_S * M_SQRT2 + ref.vel.x * c - ref.vel.y * s;
+            double clockwise = turn.getOutput() * MAX_CHASSIS_RPS + ref.vel.angle;
+            Eigen::Vector4d wheels = ik * Eigen::Vector3d(forward, -right, -clockwise);
+            // WheelSpeed::normalize
+            double fastest = wheels.cwiseAbs().maxCoeff();
+            if (fastest > MAX_SPEED_IN_S)
+                wheels *= MAX_SPEED_IN_S / fastest;
+            return wheels;
+        }
+    };
+
+    struct Stats {
+        double squaredError = 0, worstError = 0, squaredHeading = 0, endError = 0;
+        long samples = 0;
+        double solveTime = 0, worstSolve = 0;
+        long solves = 0, iterations = 0;
+
+        void track(const util::ChassisPos &pos, const util::TrajectoryState &ref) {
+            double error = std::hypot(pos.x - ref.pos.x, pos.y - ref.pos.y);
+            squaredError += error * error;
+            worstError = std::max(worstError, error);
+            squaredHeading += std::pow(wrap(pos.angle - ref.pos.angle), 2);
+            samples++;
+        }
+
+        void print(const char *name) const {
+            printf("  %-4s rms %.3f in, worst %.3f in, heading rms %.2f deg, mean end error %.3f in", name,
+                   std::sqrt(squaredError / samples), worstError, std::sqrt(squaredHeading / samples) * 180 / M_PI,
+                   endError);
+            if (solves > 0)
+                printf(", solve %.1f us mean %.1f us worst, %.1f iterations", solveTime / solves * 1e6, worstSolve * 1e6,
+                       (double)iterations / solves);
+            printf("\n");
+        }
+    };
+}
+
+int main(int argc, char **argv) {
+    util::TrajectoryConstraints constraints;
+    double lag = 0.06;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--wheel-speed") && i + 1 < argc)
+            constraints.maxWheelVelocity = MAX_SPEED_IN_S * atof(argv[++i]);
+        else if (!strcmp(argv[i], "--lag") && i + 1 < argc)
+            lag = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--verbose"))
+            verbose = true;
+        else {
+            fprintf(stderr, "usage: %s [--wheel-speed fraction] [--lag s] [--verbose]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Eigen::Matrix<double, 4, 3> ik = skills::inverseKinematics();
+    const double dt = 0.01;
+    Stats pidStats, mpcStats;
+    util::HolonomicMpc mpc(ik);
+
+    util::ChassisPos start = skills::start;
+    for (size_t i = 0; i < skills::legs.size(); i++) {
+        const skills::Leg &leg = skills::legs[i];
+        std::optional<double> heading;
+        if (!std::isnan(leg.headingDeg))
+            heading = leg.headingDeg * M_PI / 180.0;
+        util::Trajectory trajectory = util::Trajectory::plan(start, {{leg.x, leg.y, heading}}, ik, constraints);
+        // Runs a little past the end, like AutoDrive settling on the last point
+        double end = trajectory.duration() + 0.3;
+
+        Robot pidRobot(start, ik, lag), mpcRobot(start, ik, lag);
+        PidTracker pid{.ik = ik};
+        mpc.reset();
+        util::TrajectoryState horizon[util::HolonomicMpc::HORIZON + 1];
+        for (double t = 0; t < end; t += dt) {
+            util::TrajectoryState ref = trajectory.sample(t);
+            pidStats.track(pidRobot.pos, ref);
+            mpcStats.track(mpcRobot.pos, ref);
+
+            pidRobot.update(pid.step(pidRobot.pos, ref), dt);
+
+            for (int k = 0; k <= util::HolonomicMpc::HORIZON; k++)
+                horizon[k] = trajectory.sample(t + k * MPC_STEP_S);
+            auto begin = std::chrono::steady_clock::now();
+            util::WheelSpeed wheels = mpc.solve(mpcRobot.pos, horizon, MAX_SPEED_IN_S, dt);
+            double solve = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            mpcStats.solveTime += solve;
+            mpcStats.worstSolve = std::max(mpcStats.worstSolve, solve);
+            mpcStats.solves++;
+            mpcStats.iterations += mpc.getIterations();
+            mpcRobot.update(Eigen::Vector4d(wheels.lf, wheels.rf, wheels.lr, wheels.rr), dt);
+        }
+
+        util::ChassisPos goal = trajectory.end();
+        double pidEnd = std::hypot(pidRobot.pos.x - goal.x, pidRobot.pos.y - goal.y);
+        double mpcEnd = std::hypot(mpcRobot.pos.x - goal.x, mpcRobot.pos.y - goal.y);
+        pidStats.endError += pidEnd / skills::legs.size();
+        mpcStats.endError += mpcEnd / skills::legs.size();
+        if (verbose)
+            printf("  %2zu: %6.1f in, %.2f s  end error pid %.3f in, mpc %.3f in\n", i, trajectory.length(),
+                   trajectory.duration(), pidEnd, mpcEnd);
+        start = goal;
+    }
+
+    printf("%zu moves, wheels planned up to %.1f in/s of %.1f, %.0f ms wheel lag, horizon %d x %.0f ms\n",
+           skills::legs.size(), constraints.maxWheelVelocity, MAX_SPEED_IN_S, lag * 1000, util::HolonomicMpc::HORIZON,
+           MPC_STEP_S * 1000);
+    pidStats.print("pid");
+    mpcStats.print("mpc");
+    return 0;
+}
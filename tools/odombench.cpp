@@ -0,0 +1,199 @@
+// Compares the odometry integrators (see odometrystep.hpp) on a synthetic drive where the true path is known.
+// Reports how long a step takes and how far each integrator drifts from the true position.
+// Also times the EKF (see poseekf.hpp) on top of the arc integrator, fusing a noisy IMU heading and yaw rate.
+//
+// Build from the root of the repo:
+//   g++ -std=gnu++17 -O2 -Isrc -isystem /usr/include/eigen3 tools/odombench.cpp src/systemmanager/odometrystep.cpp src/systemmanager/poseekf.cpp -o odombench
+//
+// Usage:
+//   ./odombench [--seconds s]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "systemmanager/odometrystep.hpp"
+#include "systemmanager/poseekf.hpp"
+
+namespace {
+    // The true path. Smooth forward, sideways and turning speeds, like an X-drive moving around the field.
+    // Inches per second and radians per second, heading positive clockwise
+    void velocity(double t, double &forward, double &sideways, double &turn) {
+        forward = 20 + 40 * std::sin(0.3 * t);
+        sideways = 10 * std::cos(0.5 * t);
+        turn = 3 * std::sin(0.7 * t) + 0.5;
+    }
+
+    struct Drive {
+        std::vector<OdometrySample> samples;
+        std::vector<util::ChassisPos> truth;
+        std::vector<double> turnRate; // Radians per second at each sample
+    };
+
+    /**
+     * Drives the true path with very small steps, and records what the tracking wheels would read every period.
+     *
+     * \param quantize Rounds the encoders to whole ticks like the real sensors if true.
+     */
+    Drive simulate(const OdometryConfig &config, double seconds, double periodS, bool quantize) {
+        const int substeps = 200;
+        double dt = periodS / substeps;
+        double x = 0, y = 0, a = 0;
+        double left = 0, right = 0, back = 0; // Ticks
+        Drive drive;
+
+        int steps = seconds / periodS;
+        for (int i = 0; i <= steps; i++) {
+            double t = i * periodS;
+            drive.samples.push_back({(uint64_t)(t * 1e6),
+                                     quantize ? std::round(left) : left,
+                                     quantize ? std::round(right) : right,
+                                     quantize ? std::round(back) : back, 0});
+            drive.truth.push_back({x, y, a});
+            double forward, sideways, turn;
+            velocity(t, forward, sideways, turn);
+            drive.turnRate.push_back(turn);
+
+            for (int j = 0; j < substeps; j++) {
+                // Midpoint of every tiny step, way more accurate than anything being measured here
+                double forward, sideways, turn;
+                velocity(t + (j + 0.5) * dt, forward, sideways, turn);
+                double mA = a + turn * dt / 2.0;
+                x += (forward * std::sin(mA) + sideways * std::cos(mA)) * dt;
+                y += (forward * std::cos(mA) - sideways * std::sin(mA)) * dt;
+                a += turn * dt;
+
+                left += (forward + turn * config.chassisWidth / 2.0) * dt / config.leftEncToIn;
+                right += (forward - turn * config.chassisWidth / 2.0) * dt / config.rightEncToIn;
+                back += (sideways - turn * config.backToCenter) * dt / config.backEncToIn;
+            }
+        }
+        return drive;
+    }
+
+    template <typename Integrator>
+    void run(const char *name, const Drive &drive, const OdometryConfig &config) {
+        OdometryState state;
+        double finalError = 0, maxError = 0;
+        long rejected = 0;
+
+        // Repeat the run so the timing isn't just noise
+        const int repeats = 20;
+        auto begin = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            initOdometry(state, drive.samples[0], config, drive.truth[0], 0);
+            for (size_t i = 1; i < drive.samples.size(); i++) {
+                if (!stepOdometry<Integrator>(state, drive.samples[i], config))
+                    rejected++;
+                if (r == 0) {
+                    finalError = std::hypot(state.x - drive.truth[i].x, state.y - drive.truth[i].y);
+                    if (finalError > maxError)
+                        maxError = finalError;
+                }
+            }
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        double nsPerStep = elapsed * 1e9 / (repeats * (drive.samples.size() - 1));
+        double headingError = (state.angle - drive.truth.back().angle) * 180.0 / M_PI;
+
+        printf("  %-10s %7.1f ns/step  final: %9.5f in  max: %9.5f in  heading: %8.5f deg", name, nsPerStep,
+               finalError, maxError, headingError);
+        if (rejected > 0)
+            printf("  rejected: %ld", rejected / repeats);
+        printf("\n");
+    }
+
+    // What the IMU reports at each sample. The heading only changes every IMU_PERIOD_S like the real sensor
+    struct Imu {
+        std::vector<double> heading, rate; // Radians, radians per second
+    };
+
+    const double IMU_PERIOD_S = 0.01;
+
+    Imu simulateImu(const Drive &drive, double periodS) {
+        std::mt19937 random(81208);
+        std::normal_distribution<double> headingNoise(0, std::sqrt(EKF_IMU_HEADING_VARIANCE));
+        std::normal_distribution<double> rateNoise(0, 0.1 * M_PI / 180.0); // Gyro noise, before being held
+        Imu imu;
+        double heading = 0, rate = 0, nextUpdate = 0;
+        for (size_t i = 0; i < drive.truth.size(); i++) {
+            if (i * periodS >= nextUpdate - 1e-9) {
+                heading = drive.truth[i].angle + headingNoise(random);
+                rate = drive.turnRate[i] + rateNoise(random);
+                nextUpdate += IMU_PERIOD_S;
+            }
+            imu.heading.push_back(heading);
+            imu.rate.push_back(rate);
+        }
+        return imu;
+    }
+
+    // The arc integrator moving the EKF, with the IMU fused the way the odometry task does it
+    void runFilter(const char *name, const Drive &drive, const Imu &imu, const OdometryConfig &config, bool useRate) {
+        OdometryState state;
+        PoseEKF filter;
+        double finalError = 0, maxError = 0;
+
+        const int repeats = 20;
+        auto begin = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            initOdometry(state, drive.samples[0], config, drive.truth[0], 0);
+            filter.reset(drive.truth[0]);
+            for (size_t i = 1; i < drive.samples.size(); i++) {
+                stepOdometry<ArcIntegrator>(state, drive.samples[i], config);
+                filter.predict(state.lastTwist);
+                if (useRate)
+                    filter.updateYawRate(imu.rate[i], (drive.samples[i].timestamp - drive.samples[i - 1].timestamp) / 1e6,
+                                         EKF_IMU_RATE_VARIANCE);
+                if (imu.heading[i] != imu.heading[i - 1])
+                    filter.updateHeading(imu.heading[i], EKF_IMU_HEADING_VARIANCE);
+                if (r == 0) {
+                    util::ChassisPos pos = filter.getPos();
+                    finalError = std::hypot(pos.x - drive.truth[i].x, pos.y - drive.truth[i].y);
+                    if (finalError > maxError)
+                        maxError = finalError;
+                }
+            }
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        double nsPerStep = elapsed * 1e9 / (repeats * (drive.samples.size() - 1));
+        double headingError = (filter.getPos().angle - drive.truth.back().angle) * 180.0 / M_PI;
+
+        printf("  %-10s %7.1f ns/step  final: %9.5f in  max: %9.5f in  heading: %8.5f deg\n", name, nsPerStep,
+               finalError, maxError, headingError);
+    }
+}
+
+int main(int argc, char **argv) {
+    double seconds = 60;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--seconds s]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Tracking wheel heading, so the heading comes from the same encoders as the rest of the step
+    OdometryConfig config;
+    config.gyroRotation = false;
+
+    const double periods[] = {0.001, 0.005, 0.01};
+    for (bool quantize : {false, true}) {
+        for (double period : periods) {
+            printf("%.0f ms steps, %s encoders, %.0f s:\n", period * 1e3, quantize ? "whole tick" : "exact", seconds);
+            Drive drive = simulate(config, seconds, period, quantize);
+            run<ArcIntegrator>("arc", drive, config);
+            run<ExpMapIntegrator>("exp map", drive, config);
+            run<MidpointIntegrator>("midpoint", drive, config);
+            Imu imu = simulateImu(drive, period);
+            runFilter("ekf", drive, imu, config, true);
+            runFilter("ekf no rate", drive, imu, config, false);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Replays an odometry recording made on the robot (see OdometryRecorder) through the same odometry math, on a PC.
+// Useful for trying out integrator changes, chassis constants and heading modes on real match data.
+//
+// Build from the root of the repo:
+//   g++ -std=gnu++17 -O2 -Isrc tools/odomreplay.cpp src/systemmanager/odometrystep.cpp -o odomreplay
+//
+// Usage:
+//   ./odomreplay odom.bin [--width inches] [--back inches] [--gyro-heading | --encoder-heading] [--integrator arc|exp|midpoint]
+//                [--csv out.csv]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "systemmanager/odometrystep.hpp"
+#include "systemmanager/odometrylog.hpp"
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s recording.bin [--width in] [--back in] [--gyro-heading | --encoder-heading] [--integrator arc|exp|midpoint] [--csv out.csv]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (in == NULL) {
+        fprintf(stderr, "could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    OdometryLogHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != ODOMETRY_LOG_MAGIC) {
+        fprintf(stderr, "%s is not an odometry recording\n", argv[1]);
+        return 1;
+    }
+    if (header.version != ODOMETRY_LOG_VERSION) {
+        fprintf(stderr, "recording is version %u, this tool reads version %u\n", header.version, ODOMETRY_LOG_VERSION);
+        return 1;
+    }
+
+    // Start from the constants the robot used, then apply any overrides
+    OdometryConfig config;
+    config.leftEncToIn = header.leftEncToIn;
+    config.rightEncToIn = header.rightEncToIn;
+    config.backEncToIn = header.backEncToIn;
+    config.chassisWidth = header.chassisWidth;
+    config.backToCenter = header.backToCenter;
+    int headingOverride = -1; // -1 = as recorded, 0 = encoders, 1 = gyro
+    FILE *csv = NULL;
+    bool (*step)(OdometryState&, const OdometrySample&, const OdometryConfig&) = stepOdometry;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--width") && i + 1 < argc)
+            config.chassisWidth = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--back") && i + 1 < argc)
+            config.backToCenter = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--gyro-heading"))
+            headingOverride = 1;
+        else if (!strcmp(argv[i], "--encoder-heading"))
+            headingOverride = 0;
+        else if (!strcmp(argv[i], "--integrator") && i + 1 < argc) {
+            i++;
+            if (!strcmp(argv[i], "arc"))
+                step = stepOdometry<ArcIntegrator>;
+            else if (!strcmp(argv[i], "exp"))
+                step = stepOdometry<ExpMapIntegrator>;
+            else if (!strcmp(argv[i], "midpoint"))
+                step = stepOdometry<MidpointIntegrator>;
+            else {
+                fprintf(stderr, "unknown integrator %s\n", argv[i]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--csv") && i + 1 < argc) {
+            csv = fopen(argv[++i], "w");
+            if (csv == NULL) {
+                fprintf(stderr, "could not open %s\n", argv[i]);
+                return 1;
+            }
+            fprintf(csv, "time_us,x,y,angle\n");
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    OdometryState state;
+    OdometryLogRecord record;
+    util::ChassisPos start;
+    double zeroPosA = 0;
+    bool started = false, initPending = false, recordedGyro = true;
+    long samples = 0, rejected = 0, starts = 0;
+    uint32_t lastTime = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    while (fread(&record, sizeof(record), 1, in) == 1) {
+        if (record.type == OdometryLogRecord::START) {
+            config.gyroRotation = record.flags & OdometryLogRecord::GYRO_ROTATION;
+            config.redSide = record.flags & OdometryLogRecord::RED_SIDE;
+            recordedGyro = config.gyroRotation;
+            if (headingOverride >= 0)
+                config.gyroRotation = headingOverride;
+            start = {record.start.x, record.start.y, record.start.angle};
+            zeroPosA = record.start.zeroPosA;
+            initPending = true;
+            starts++;
+            continue;
+        }
+
+        OdometrySample sample = {record.time, (double)record.sample.left, (double)record.sample.right,
+                                 (double)record.sample.back, record.sample.gyro};
+        lastTime = record.time;
+        if (initPending) {
+            initOdometry(state, sample, config, start, zeroPosA);
+            // The recorded gyro offset doesn't fit if the recording used the tracking wheels for heading.
+            // Line the gyro up with the recorded starting angle instead
+            if (config.gyroRotation && !recordedGyro) {
+                state.lastA = start.angle * (config.redSide ? 1.0 : -1.0);
+                state.zeroPosA = sample.gyro * M_PI / 180.0 - state.lastA;
+            }
+            initPending = false;
+            started = true;
+            continue;
+        }
+        if (!started)
+            continue;
+
+        samples++;
+        if (!step(state, sample, config))
+            rejected++;
+        else if (csv != NULL)
+            fprintf(csv, "%u,%f,%f,%f\n", record.time, state.x, state.y, state.angle);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    fclose(in);
+    if (csv != NULL)
+        fclose(csv);
+
+    printf("starts: %ld, samples: %ld, rejected: %ld\n", starts, samples, rejected);
+    printf("recording length: %.3f s, replayed in %.3f ms\n", lastTime / 1e6, elapsed * 1e3);
+    printf("final pose: x: %.3f, y: %.3f, a: %.3f deg\n", state.x, state.y, state.angle * 180.0 / M_PI);
+    return 0;
+}
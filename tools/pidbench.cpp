@@ -0,0 +1,264 @@
+// Compares the cost of stepping util::Pid (see pid.hpp) with an okapi style controller, on a simulated drive axis.
+// Reports the time per step, how many heap allocations building and stepping each one takes, and checks util::Pid
+// gives the same output as the okapi style controller when stepped on the same schedule.
+//
+// okapi only ships as a library built for the V5, so the okapi style controller below is a copy of the work
+// IterativePosPIDController::step does: a virtual timer read through a virtual clock, a derivative filter and a
+// SettledUtil with its own timer, each owned through std::unique_ptr, with the same math and default settings.
+//
+// Build from the root of the repo:
+//   g++ -std=gnu++17 -O2 -Isrc tools/pidbench.cpp -o pidbench
+//
+// Usage:
+//   ./pidbench [--steps n]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include "profiles.hpp"
+#include "util/pid.hpp"
+
+namespace {
+    size_t allocations = 0;
+}
+
+// Counts every allocation. The other forms all go through these two, so new and delete always pair up.
+// Kept out of line, otherwise GCC inlines them into the callers and warns that free() gets a pointer from new
+__attribute__((noinline)) void *operator new(size_t size) {
+    allocations++;
+    if (void *p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void *operator new[](size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    ::operator delete(p);
+}
+
+void operator delete[](void *p) noexcept {
+    ::operator delete(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    ::operator delete(p);
+}
+
+namespace {
+    // Stands in for pros::millis(), advanced by the simulation
+    struct Clock {
+        virtual ~Clock() = default;
+        virtual double millis() const = 0;
+    };
+
+    struct SimClock : Clock {
+        double now = 0;
+        double millis() const override {
+            return now;
+        }
+    };
+
+    struct Timer {
+        explicit Timer(const Clock &clock) : clock(clock) {
+        }
+        virtual ~Timer() = default;
+        virtual void placeHardMark() {
+            if (hardMark < 0)
+                hardMark = clock.millis();
+        }
+        virtual double getDtFromHardMark() const {
+            return hardMark < 0 ? 0 : clock.millis() - hardMark;
+        }
+        virtual void clearHardMark() {
+            hardMark = -1;
+        }
+
+        const Clock &clock;
+        double hardMark = -1;
+    };
+
+    struct Filter {
+        virtual ~Filter() = default;
+        virtual double filter(double input) = 0;
+    };
+
+    struct PassthroughFilter : Filter {
+        double filter(double input) override {
+            return input;
+        }
+    };
+
+    struct SettledUtil {
+        explicit SettledUtil(std::unique_ptr<Timer> timer) : timer(std::move(timer)) {
+        }
+        virtual ~SettledUtil() = default;
+        virtual bool isSettled(double error) {
+            if (std::fabs(error) <= 50 && std::fabs(error - lastError) <= 5) {
+                timer->placeHardMark();
+                settled = timer->getDtFromHardMark() >= 250;
+            } else {
+                timer->clearHardMark();
+                settled = false;
+            }
+            lastError = error;
+            return settled;
+        }
+
+        std::unique_ptr<Timer> timer;
+        double lastError = 0;
+        bool settled = false;
+    };
+
+    // IterativePosPIDController's step with its defaults: 10ms sample time, output and integral limits of ±1,
+    // integral reset on zero crossing, derivative on measurement through a passthrough filter
+    class OkapiStylePid {
+    public:
+        OkapiStylePid(double kP, double kI, double kD, const Clock &clock)
+            : kP(kP), kI(kI * 0.01), kD(kD / 0.01), loopDtTimer(std::make_unique<Timer>(clock)),
+              settledUtil(std::make_unique<SettledUtil>(std::make_unique<Timer>(clock))),
+              derivativeFilter(std::make_unique<PassthroughFilter>()) {
+        }
+
+        double step(double reading) {
+            loopDtTimer->placeHardMark();
+            if (loopDtTimer->getDtFromHardMark() >= 10) {
+                error = target - reading;
+                integral += kI * error;
+                if (std::copysign(1.0, error) != std::copysign(1.0, lastError))
+                    integral = 0;
+                integral = std::clamp(integral, -1.0, 1.0);
+                double derivative = derivativeFilter->filter(reading - lastReading);
+                output = std::clamp(kP * error + integral - kD * derivative, -1.0, 1.0);
+                lastReading = reading;
+                lastError = error;
+                recomputes++;
+                loopDtTimer->clearHardMark();
+                settledUtil->isSettled(error);
+            }
+            return output;
+        }
+
+        long recomputes = 0;
+
+    private:
+        double kP, kI, kD;
+        double target = 0, error = 0, lastError = 0, lastReading = 0, integral = 0, output = 0;
+        std::unique_ptr<Timer> loopDtTimer;
+        std::unique_ptr<SettledUtil> settledUtil;
+        std::unique_ptr<Filter> derivativeFilter;
+    };
+
+    // A drive axis with a little lag, driven towards 0 from 24 inches away and pushed off again every 2 seconds
+    struct Plant {
+        double position = 24, velocity = 0;
+        int stepCount = 0;
+
+        double update(double power) {
+            velocity += (power * MAX_SPEED_IN_S - velocity) * 0.2;
+            position += velocity * 0.01;
+            if (++stepCount % 200 == 0)
+                position += 24;
+            return position;
+        }
+    };
+
+    struct Result {
+        double nsPerStep;
+        size_t stepAllocations;
+        double checksum;
+    };
+
+    // Steps a controller for a number of 10ms loops of the simulated drive axis. step is called with the reading
+    template <typename Step>
+    Result run(long steps, Step step, SimClock &clock) {
+        Plant plant;
+        clock.now = 0;
+        size_t before = allocations;
+        double reading = plant.position, checksum = 0;
+
+        auto begin = std::chrono::steady_clock::now();
+        for (long i = 0; i < steps; i++) {
+            clock.now += 10;
+            double output = step(-reading);
+            reading = plant.update(output);
+            checksum += output;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return {seconds * 1e9 / steps, allocations - before, checksum};
+    }
+
+    void print(const char *name, size_t constructAllocations, const Result &result) {
+        printf("  %-22s %7.2f ns/step   %zu allocations to build, %zu while stepping\n", name, result.nsPerStep,
+               constructAllocations, result.stepAllocations);
+    }
+}
+
+int main(int argc, char **argv) {
+    long steps = 10000000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--steps") && i + 1 < argc)
+            steps = atol(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--steps n]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    SimClock clock;
+    size_t before = allocations;
+    OkapiStylePid okapi(FORWARD_P, FORWARD_I, FORWARD_D, clock);
+    size_t okapiAllocations = allocations - before;
+    Result okapiResult = run(steps, [&](double reading) { return okapi.step(reading); }, clock);
+
+    before = allocations;
+    util::Pid<> pid(FORWARD_P, FORWARD_I, FORWARD_D);
+    util::Pid<float> pidFloat(FORWARD_P, FORWARD_I, FORWARD_D);
+    util::Pid<double, util::PID_OKAPI | util::PID_MEASURED_DT> pidMeasured(FORWARD_P, FORWARD_I, FORWARD_D);
+    size_t pidAllocations = allocations - before;
+    Result pidResult = run(steps, [&](double reading) { return pid.step(reading); }, clock);
+    Result floatResult = run(steps, [&](double reading) { return pidFloat.step(reading); }, clock);
+    Result measuredResult = run(steps, [&](double reading) { return pidMeasured.step(reading, 0.01); }, clock);
+
+    // okapi's timer places its mark on the call after each recompute and recomputes once 10ms have passed since,
+    // so stepped every 10ms it only recomputes on every other call. util::Pid stepped on those same calls
+    // should give the same output
+    SimClock sideClock;
+    OkapiStylePid reference(FORWARD_P, FORWARD_I, FORWARD_D, sideClock);
+    util::Pid<> candidate(FORWARD_P, FORWARD_I, FORWARD_D);
+    Plant plant;
+    double reading = plant.position, worst = 0;
+    const int sideSteps = 100000;
+    for (int i = 0; i < sideSteps; i++) {
+        long recomputes = reference.recomputes;
+        double expected = reference.step(-reading);
+        if (reference.recomputes != recomputes)
+            worst = std::max(worst, std::fabs(candidate.step(-reading) - expected));
+        reading = plant.update(expected);
+        sideClock.now += 10;
+    }
+
+    printf("%ld steps of the forward controller (P %g, I %g, D %g)\n", steps, FORWARD_P, FORWARD_I, FORWARD_D);
+    print("okapi style", okapiAllocations, okapiResult);
+    print("util::Pid<double>", pidAllocations, pidResult);
+    print("util::Pid<float>", pidAllocations, floatResult);
+    print("util::Pid measured dt", pidAllocations, measuredResult);
+    printf("  okapi style recomputed on %ld of %ld calls (%.2f ns per recompute)\n", okapi.recomputes, steps,
+           okapiResult.nsPerStep * steps / okapi.recomputes);
+    printf("  side by side over %d s: okapi style recomputed %ld times, largest difference %.3g\n", sideSteps / 100,
+           reference.recomputes, worst);
+    // Keeps the compiler from throwing the loops away
+    if (okapiResult.checksum + pidResult.checksum + floatResult.checksum + measuredResult.checksum == 1234.5)
+        printf(" \n");
+    return 0;
+}
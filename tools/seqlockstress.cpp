@@ -0,0 +1,137 @@
+// Hammers util::SeqLock (see seqlock.hpp) with one writer and several readers, and checks that no read ever returns
+// a torn value, half from one write and half from another.
+//
+// Every field of each value is filled from the same counter, so a torn read shows up as fields that disagree.
+// Runs a plain struct and one holding an Eigen matrix, like PoseSnapshot. The host's threads really run at the same
+// time on several cores, which is harder on the lock than the V5's single user core.
+//
+// Build from the root of the repo:
+//   g++ -std=gnu++17 -O2 -pthread -DSEQLOCK_NO_PROS -Isrc -isystem /usr/include/eigen3 tools/seqlockstress.cpp -o seqlockstress
+//
+// Usage:
+//   ./seqlockstress [--seconds s] [--readers n]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "Eigen/Core"
+#include "util/seqlock.hpp"
+
+namespace {
+    /// Plain values, about the size of OdometryStats
+    struct Plain {
+        uint64_t sequence;
+        double values[15];
+
+        void fill(uint64_t n) {
+            sequence = n;
+            for (double &value : values)
+                value = (double)n;
+        }
+        bool consistent() const {
+            for (double value : values)
+                if (value != (double)sequence)
+                    return false;
+            return true;
+        }
+    };
+
+    /// Shaped like PoseSnapshot, with a fixed size Eigen matrix next to plain values
+    struct WithMatrix {
+        uint64_t sequence;
+        double x, y, angle;
+        Eigen::Matrix3d covariance;
+
+        void fill(uint64_t n) {
+            sequence = n;
+            x = y = angle = (double)n;
+            covariance.setConstant((double)n);
+        }
+        bool consistent() const {
+            return x == (double)sequence && y == (double)sequence && angle == (double)sequence &&
+                   (covariance.array() == (double)sequence).all();
+        }
+    };
+
+    struct Result {
+        uint64_t writes = 0, reads = 0, torn = 0, backwards = 0;
+        uint32_t retries = 0;
+    };
+
+    template <typename T>
+    Result run(double seconds, int readers) {
+        util::SeqLock<T> lock;
+        std::atomic<bool> running{true};
+        std::vector<uint64_t> reads(readers), torn(readers), backwards(readers);
+        Result result;
+
+        std::thread writer([&] {
+            T value;
+            uint64_t n = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                value.fill(++n);
+                lock.write(value);
+            }
+            result.writes = n;
+        });
+
+        std::vector<std::thread> threads;
+        for (int r = 0; r < readers; r++) {
+            threads.emplace_back([&, r] {
+                uint64_t last = 0;
+                while (running.load(std::memory_order_relaxed)) {
+                    T value = lock.read();
+                    reads[r]++;
+                    if (!value.consistent())
+                        torn[r]++;
+                    // A reader must never see an older value after a newer one
+                    if (value.sequence < last)
+                        backwards[r]++;
+                    last = value.sequence;
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        running = false;
+        writer.join();
+        for (std::thread &thread : threads)
+            thread.join();
+
+        for (int r = 0; r < readers; r++) {
+            result.reads += reads[r];
+            result.torn += torn[r];
+            result.backwards += backwards[r];
+        }
+        result.retries = lock.getRetryCount();
+        return result;
+    }
+
+    bool report(const char *name, const Result &result) {
+        printf("%-12s %12llu writes %12llu reads %10u retries %6llu torn %6llu out of order\n", name,
+               (unsigned long long)result.writes, (unsigned long long)result.reads, result.retries,
+               (unsigned long long)result.torn, (unsigned long long)result.backwards);
+        return result.torn == 0 && result.backwards == 0;
+    }
+}
+
+int main(int argc, char **argv) {
+    double seconds = 2;
+    int readers = 3;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--seconds"))
+            seconds = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--readers"))
+            readers = atoi(argv[i + 1]);
+    }
+
+    printf("1 writer, %d readers, %.1fs each\n", readers, seconds);
+    bool ok = report("plain", run<Plain>(seconds, readers));
+    ok = report("eigen", run<WithMatrix>(seconds, readers)) && ok;
+    printf(ok ? "No torn reads\n" : "TORN READS FOUND\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+// The skills routine's moves and the drive geometry, shared by the host benches (trajbench.cpp, mpcbench.cpp).
+// Keep the table in step with autoRoutine.cpp.
+
+#ifndef _TOOLS_SKILLSROUTINE_HPP_INCLUDED
+#define _TOOLS_SKILLSROUTINE_HPP_INCLUDED
+
+#include <cmath>
+#include <vector>
+#include "Eigen/Core"
+#include "profiles.hpp"
+#include "util/struct.hpp"
+
+namespace skills {
+    const double NONE = NAN;
+
+    // One move from the skills routine. DRIVE_TO_POINT and each point of a FOLLOW_PATH take the heading from the
+    // last TURN_TO_ANGLE_DEG before them, DRIVE_TO_POSE its own heading
+    struct Leg {
+        double x, y;
+        double headingDeg; // NONE if the robot just faces where it's going
+    };
+
+    // Where the routine starts, angle in radians
+    const util::ChassisPos start = {-72 + 11.25 / 2 + CHASSIS_WIDTH / 2, STARTING_Y_IN, 0};
+
+    // The skills routine from autoRoutine.cpp, in order
+    const std::vector<Leg> legs = {
+        {-72 + GOAL_RADIUS_IN / 2 + CHASSIS_WIDTH / 2, 24, NONE},
+        {-36, 24, 90},
+        {-30, 30, NONE},
+        {-17, 17, NONE},
+        {-36, 46, NONE},
+        {-73.8, 46.5, -90},
+        {-72, 18, 180},
+        {-84, 48, NONE},
+        {-108, 24 - 2, -132},
+        {-142 + 34, 34, -135},
+        {-142 + 17 - 3, 16 - 4, NONE},
+        {-144 + 48 - 3, 72 - 24, NONE},
+        {-144 + 48 - 3, 72 - 2, 0},
+        {-144 + 26, 72 - 2, -90},
+        {-144 + 16 - 2, 72 - 2, NONE},
+        {-144 + 36, 73, NONE},
+        {-144 + 24, 144 - 24, -45},
+        {-144 + 16 - 0.5, 144 - 16 - 2, NONE},
+        {-144 + 36, 144 - 46, 90},
+        {-73.8, 144 - 46, NONE},
+        {-72, 144 - 18, 0},
+        {-60, 144 - 48, NONE},
+        {-36, 144 - 22, 42},
+        {-34, 144 - 34, 45},
+        {-17 + 3, 144 - (16 - 3), NONE},
+        {-48 + 3, 72 + 24, 180},
+    };
+
+    // Same matrix as InverseKinematics with the center of rotation in the middle of the robot
+    inline Eigen::Matrix<double, 4, 3> inverseKinematics() {
+        double x = BASE_LENGTH_IN / 2.0, y = BASE_WIDTH_IN / 2.0;
+        Eigen::Matrix<double, 4, 3> m;
+        m << 1, -1, -(x + y),
+             1, 1, x + y,
+             1, 1, -x - y,
+             1, -1, x + y;
+        return m / M_SQRT2;
+    }
+}
+#endif /* _TOOLS_SKILLSROUTINE_HPP_INCLUDED */
@@ -0,0 +1,122 @@
+// Plans the skills routine's moves as trajectories (see trajectory.hpp) and compares them with driving and turning
+// separately, the way the routine does with DRIVE_TO_POINT and TURN_TO_ANGLE_DEG.
+// Reports how long planning takes, how long the robot would take, and the highest wheel speed and acceleration
+// the planned trajectories ask for. Fails if those go over the limits the trajectories were planned with.
+//
+// Build from the root of the repo:
+//   g++ -std=gnu++17 -O2 -Isrc -isystem /usr/include/eigen3 tools/trajbench.cpp src/util/math/trajectory.cpp src/util/math/motionprofile.cpp -o trajbench
+//
+// Usage:
+//   ./trajbench [--accel in/s²] [--verbose]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "profiles.hpp"
+#include "skillsroutine.hpp"
+#include "util/math/trajectory.hpp"
+#include "util/math/motionprofile.hpp"
+
+namespace {
+    // Highest wheel speed and acceleration along a trajectory, checked by sampling it finely
+    void wheelPeaks(const util::Trajectory &trajectory, const Eigen::Matrix<double, 4, 3> &ik, double &speed,
+                    double &accel) {
+        const double dt = 0.001;
+        Eigen::Vector4d last = Eigen::Vector4d::Zero();
+        for (double t = 0; t <= trajectory.duration(); t += dt) {
+            util::TrajectoryState state = trajectory.sample(t);
+            double a = state.pos.angle;
+            double forward = state.vel.x * std::sin(a) + state.vel.y * std::cos(a);
+            double right = state.vel.x * std::cos(a) - state.vel.y * std::sin(a);
+            Eigen::Vector4d wheels = ik * Eigen::Vector3d(forward, -right, -state.vel.angle);
+            speed = std::max(speed, wheels.cwiseAbs().maxCoeff());
+            if (t > 0)
+                accel = std::max(accel, ((wheels - last) / dt).cwiseAbs().maxCoeff());
+            last = wheels;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    util::TrajectoryConstraints constraints;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--accel") && i + 1 < argc)
+            constraints.maxWheelAcceleration = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--verbose"))
+            verbose = true;
+        else {
+            fprintf(stderr, "usage: %s [--accel in/s²] [--verbose]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Eigen::Matrix<double, 4, 3> ik = skills::inverseKinematics();
+    util::ProfileConstraints drive = {PROFILE_MAX_VEL_IN_S, PROFILE_MAX_ACCEL_IN_S2, PROFILE_MAX_JERK_IN_S3};
+    util::ProfileConstraints turn = {PROFILE_MAX_TURN_RPS, PROFILE_MAX_TURN_ACCEL, PROFILE_MAX_TURN_JERK};
+
+    util::ChassisPos pos = skills::start;
+    double planTime = 0, trajectoryTime = 0, separateTime = 0, peakSpeed = 0, peakAccel = 0;
+    size_t worstPlan = 0;
+
+    for (size_t i = 0; i < skills::legs.size(); i++) {
+        const skills::Leg &leg = skills::legs[i];
+        std::optional<double> heading;
+        if (!std::isnan(leg.headingDeg))
+            heading = leg.headingDeg * M_PI / 180.0;
+
+        // Plans a few times so the timing isn't just noise
+        const int repeats = 50;
+        util::Trajectory trajectory;
+        auto begin = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++)
+            trajectory = util::Trajectory::plan(pos, {{leg.x, leg.y, heading}}, ik, constraints);
+        double plan = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() / repeats;
+        planTime += plan;
+        if (plan * 1e6 > worstPlan)
+            worstPlan = plan * 1e6;
+        double legSpeed = 0, legAccel = 0;
+        wheelPeaks(trajectory, ik, legSpeed, legAccel);
+        peakSpeed = std::max(peakSpeed, legSpeed);
+        peakAccel = std::max(peakAccel, legAccel);
+
+        // Turning in place, then driving in a straight line
+        double turnTime = 0;
+        if (heading)
+            turnTime = util::MotionProfile::sCurve(std::remainder(*heading - pos.angle, 2 * M_PI), turn).duration();
+        double driveTime = util::MotionProfile::sCurve(std::hypot(leg.x - pos.x, leg.y - pos.y), drive).duration();
+
+        trajectoryTime += trajectory.duration();
+        separateTime += turnTime + driveTime;
+        if (verbose)
+            printf("  %2zu: (%7.2f, %6.2f) %6.1f in  trajectory %.3f s  separate %.3f s  plan %5.0f us  peak %5.1f in/s %6.1f in/s²\n",
+                   i, leg.x, leg.y, trajectory.length(), trajectory.duration(), turnTime + driveTime, plan * 1e6,
+                   legSpeed, legAccel);
+
+        pos = trajectory.end();
+    }
+
+    printf("%zu moves, wheel limits %.1f in/s and %.0f in/s²\n", skills::legs.size(), constraints.maxWheelVelocity,
+           constraints.maxWheelAcceleration);
+    printf("  plan:       %8.0f us total, %zu us worst move\n", planTime * 1e6, worstPlan);
+    printf("  trajectory: %8.3f s\n", trajectoryTime);
+    printf("  separate:   %8.3f s (turn, then drive)\n", separateTime);
+    printf("  peak wheel speed %.2f in/s, acceleration %.2f in/s²\n", peakSpeed, peakAccel);
+
+    // sample() blends the heading and wheel rates linearly between the planned points, which the planner doesn't see.
+    // That's worth a few tenths of a percent, anything past it is the planner going over the limits
+    const double tolerance = 1.01;
+    bool ok = true;
+    if (peakSpeed > constraints.maxWheelVelocity * tolerance) {
+        printf("FAIL: peak wheel speed is over the %.1f in/s limit\n", constraints.maxWheelVelocity);
+        ok = false;
+    }
+    if (peakAccel > constraints.maxWheelAcceleration * tolerance) {
+        printf("FAIL: peak wheel acceleration is over the %.0f in/s² limit\n", constraints.maxWheelAcceleration);
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}